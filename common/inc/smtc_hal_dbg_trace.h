@@ -75,9 +75,93 @@ extern "C" {
 #define HAL_DBG_TRACE_COLOR_DEFAULT ""
 #endif
 
+/*!
+ * @brief Trace levels, from the most to the least severe
+ */
+#define HAL_DBG_TRACE_LEVEL_OFF 0
+#define HAL_DBG_TRACE_LEVEL_ERROR 1
+#define HAL_DBG_TRACE_LEVEL_WARNING 2
+#define HAL_DBG_TRACE_LEVEL_INFO 3
+
+/*!
+ * @brief Most verbose level compiled into the current module
+ *
+ * Define it before the first include to change the level of one source file, e.g.
+ * `#define HAL_DBG_TRACE_MODULE_LEVEL HAL_DBG_TRACE_LEVEL_WARNING`. Traces above the level
+ * are removed at compile time, together with their format strings. HAL_DBG_TRACE_PRINTF,
+ * HAL_DBG_TRACE_MSG and HAL_DBG_TRACE_ARRAY count as INFO.
+ */
+#ifndef HAL_DBG_TRACE_MODULE_LEVEL
+#define HAL_DBG_TRACE_MODULE_LEVEL HAL_DBG_TRACE_LEVEL_INFO
+#endif
+
+#define HAL_DBG_TRACE_ENABLED( level ) ( HAL_DBG_TRACE_MODULE_LEVEL >= ( level ) )
+
 #if( HAL_DBG_TRACE ) && !defined( PERF_TEST_ENABLED )
 
-#define HAL_DBG_TRACE_PRINTF( ... ) hal_mcu_trace_print( __VA_ARGS__ )
+#if( HAL_DBG_TRACE_TOKENIZED == HAL_FEATURE_ON )
+
+/*!
+ * @brief Tokenized traces
+ *
+ * Each format string is placed in the HAL_DBG_TRACE_FMT_SECTION section and only its offset
+ * in that section (the token) is sent, followed by the raw arguments. tools/trace_decode.py
+ * reads the strings back from the ELF file and prints the text. Levels, prefixes and colors
+ * are added by the decoder.
+ */
+#define HAL_DBG_TRACE_FMT_SECTION "hal_trace_fmt"
+
+#define HAL_DBG_TRACE_TOKEN_PLAIN 0x40  // No level prefix (HAL_DBG_TRACE_PRINTF)
+#define HAL_DBG_TRACE_TOKEN_ARRAY 0x80  // Raw byte array follows instead of arguments
+
+#define HAL_DBG_TRACE_TOKEN( level, flags, fmt, ... )                                                  \
+    do                                                                                                 \
+    {                                                                                                  \
+        if( HAL_DBG_TRACE_ENABLED( level ) )                                                           \
+        {                                                                                              \
+            static const char hal_trace_fmt_[] __attribute__( ( section( HAL_DBG_TRACE_FMT_SECTION ) ) ) = \
+                fmt;                                                                                   \
+            hal_mcu_trace_token( ( level ) | ( flags ), hal_trace_fmt_, ##__VA_ARGS__ );               \
+        }                                                                                              \
+    } while( 0 )
+
+#define HAL_DBG_TRACE_PRINTF( ... ) \
+    HAL_DBG_TRACE_TOKEN( HAL_DBG_TRACE_LEVEL_INFO, HAL_DBG_TRACE_TOKEN_PLAIN, __VA_ARGS__ )
+
+#define HAL_DBG_TRACE_MSG( msg ) HAL_DBG_TRACE_PRINTF( msg );
+
+#define HAL_DBG_TRACE_MSG_COLOR( msg, color ) HAL_DBG_TRACE_PRINTF( msg );
+
+#define HAL_DBG_TRACE_INFO( ... ) HAL_DBG_TRACE_TOKEN( HAL_DBG_TRACE_LEVEL_INFO, 0, __VA_ARGS__ );
+
+#define HAL_DBG_TRACE_WARNING( ... ) HAL_DBG_TRACE_TOKEN( HAL_DBG_TRACE_LEVEL_WARNING, 0, __VA_ARGS__ );
+
+#define HAL_DBG_TRACE_ERROR( ... ) HAL_DBG_TRACE_TOKEN( HAL_DBG_TRACE_LEVEL_ERROR, 0, __VA_ARGS__ );
+
+#define HAL_DBG_TRACE_ARRAY( msg, array, len )                                                         \
+    do                                                                                                 \
+    {                                                                                                  \
+        if( HAL_DBG_TRACE_ENABLED( HAL_DBG_TRACE_LEVEL_INFO ) )                                        \
+        {                                                                                              \
+            static const char hal_trace_fmt_[] __attribute__( ( section( HAL_DBG_TRACE_FMT_SECTION ) ) ) = \
+                msg;                                                                                   \
+            hal_mcu_trace_token_array( HAL_DBG_TRACE_LEVEL_INFO | HAL_DBG_TRACE_TOKEN_ARRAY, hal_trace_fmt_, \
+                                       ( const uint8_t* ) ( array ), ( uint32_t ) ( len ) );           \
+        }                                                                                              \
+    } while( 0 );
+
+#define HAL_DBG_TRACE_PACKARRAY( msg, array, len ) HAL_DBG_TRACE_ARRAY( msg, array, len )
+
+#else
+
+#define HAL_DBG_TRACE_PRINTF( ... )                             \
+    do                                                          \
+    {                                                           \
+        if( HAL_DBG_TRACE_ENABLED( HAL_DBG_TRACE_LEVEL_INFO ) ) \
+        {                                                       \
+            hal_mcu_trace_print( __VA_ARGS__ );                 \
+        }                                                       \
+    } while( 0 )
 
 #define HAL_DBG_TRACE_MSG( msg )                             \
     do                                                       \
@@ -94,31 +178,40 @@ extern "C" {
         HAL_DBG_TRACE_PRINTF( HAL_DBG_TRACE_COLOR_DEFAULT ); \
     } while( 0 );
 
-#define HAL_DBG_TRACE_INFO( ... )                            \
-    do                                                       \
-    {                                                        \
-        HAL_DBG_TRACE_PRINTF( HAL_DBG_TRACE_COLOR_GREEN );   \
-        HAL_DBG_TRACE_PRINTF( "INFO: " );                    \
-        HAL_DBG_TRACE_PRINTF( __VA_ARGS__ );                 \
-        HAL_DBG_TRACE_PRINTF( HAL_DBG_TRACE_COLOR_DEFAULT ); \
+#define HAL_DBG_TRACE_INFO( ... )                                \
+    do                                                           \
+    {                                                            \
+        if( HAL_DBG_TRACE_ENABLED( HAL_DBG_TRACE_LEVEL_INFO ) )  \
+        {                                                        \
+            hal_mcu_trace_print( HAL_DBG_TRACE_COLOR_GREEN );    \
+            hal_mcu_trace_print( "INFO: " );                     \
+            hal_mcu_trace_print( __VA_ARGS__ );                  \
+            hal_mcu_trace_print( HAL_DBG_TRACE_COLOR_DEFAULT );  \
+        }                                                        \
     } while( 0 );
 
-#define HAL_DBG_TRACE_WARNING( ... )                         \
-    do                                                       \
-    {                                                        \
-        HAL_DBG_TRACE_PRINTF( HAL_DBG_TRACE_COLOR_YELLOW );  \
-        HAL_DBG_TRACE_PRINTF( "WARN: " );                    \
-        HAL_DBG_TRACE_PRINTF( __VA_ARGS__ );                 \
-        HAL_DBG_TRACE_PRINTF( HAL_DBG_TRACE_COLOR_DEFAULT ); \
+#define HAL_DBG_TRACE_WARNING( ... )                               \
+    do                                                             \
+    {                                                              \
+        if( HAL_DBG_TRACE_ENABLED( HAL_DBG_TRACE_LEVEL_WARNING ) ) \
+        {                                                          \
+            hal_mcu_trace_print( HAL_DBG_TRACE_COLOR_YELLOW );     \
+            hal_mcu_trace_print( "WARN: " );                       \
+            hal_mcu_trace_print( __VA_ARGS__ );                    \
+            hal_mcu_trace_print( HAL_DBG_TRACE_COLOR_DEFAULT );    \
+        }                                                          \
     } while( 0 );
 
-#define HAL_DBG_TRACE_ERROR( ... )                           \
-    do                                                       \
-    {                                                        \
-        HAL_DBG_TRACE_PRINTF( HAL_DBG_TRACE_COLOR_RED );     \
-        HAL_DBG_TRACE_PRINTF( "ERROR: " );                   \
-        HAL_DBG_TRACE_PRINTF( __VA_ARGS__ );                 \
-        HAL_DBG_TRACE_PRINTF( HAL_DBG_TRACE_COLOR_DEFAULT ); \
+#define HAL_DBG_TRACE_ERROR( ... )                               \
+    do                                                           \
+    {                                                            \
+        if( HAL_DBG_TRACE_ENABLED( HAL_DBG_TRACE_LEVEL_ERROR ) ) \
+        {                                                        \
+            hal_mcu_trace_print( HAL_DBG_TRACE_COLOR_RED );      \
+            hal_mcu_trace_print( "ERROR: " );                    \
+            hal_mcu_trace_print( __VA_ARGS__ );                  \
+            hal_mcu_trace_print( HAL_DBG_TRACE_COLOR_DEFAULT );  \
+        }                                                        \
     } while( 0 );
 
 #define HAL_DBG_TRACE_ARRAY( msg, array, len )                                \
@@ -145,6 +238,8 @@ extern "C" {
         }                                                \
     } while( 0 );
 
+#endif  // HAL_DBG_TRACE_TOKENIZED
+
 #else
 #define HAL_DBG_TRACE_PRINTF( ... )
 #define HAL_DBG_TRACE_MSG( msg )
@@ -179,10 +274,28 @@ extern "C" {
  */
 
 /**
- * @brief
+ * @brief Format a trace and queue it for the UART
  */
 void hal_mcu_trace_print( const char* fmt, ... );
 
+/**
+ * @brief Queue a tokenized trace: level, token of @p fmt and the raw arguments
+ *
+ * @param[in] level Trace level, with the HAL_DBG_TRACE_TOKEN_PLAIN flag for plain prints
+ * @param[in] fmt   Format string placed in the HAL_DBG_TRACE_FMT_SECTION section
+ */
+void hal_mcu_trace_token( uint8_t level, const char* fmt, ... );
+
+/**
+ * @brief Queue a tokenized trace carrying a raw byte array, printed in hex by the decoder
+ *
+ * @param[in] level Trace level, with the HAL_DBG_TRACE_TOKEN_ARRAY flag
+ * @param[in] msg   Message placed in the HAL_DBG_TRACE_FMT_SECTION section
+ * @param[in] array Bytes to send
+ * @param[in] len   Number of bytes (longer arrays are cut to the trace frame size)
+ */
+void hal_mcu_trace_token_array( uint8_t level, const char* msg, const uint8_t* array, uint32_t len );
+
 #ifdef __cplusplus
 }
 #endif
@@ -64,6 +64,12 @@ extern "C" {
 #endif // HAL_DBG_TRACE
 #define HAL_DBG_TRACE_COLOR                         HAL_FEATURE_ON
 
+/* HAL_FEATURE_ON to send traces as binary tokens (format string token + raw arguments)
+   instead of text. Decode them on the host with tools/trace_decode.py */
+#ifndef HAL_DBG_TRACE_TOKENIZED
+#define HAL_DBG_TRACE_TOKENIZED                     HAL_FEATURE_OFF
+#endif // HAL_DBG_TRACE_TOKENIZED
+
 /* HAL_FEATURE_ON to activate sleep mode */
 
 /* HAL_FEATURE_OFF to deactivate sleep mode */
@@ -86,8 +86,40 @@ void uart_init( void );
  */
 void uart_init_with_rx_callback( void ( *callback_rx )( uint8_t data ) );
 
+/**
+ * @brief Format a log message and queue it for the UART
+ *
+ * Never blocks: the text is appended to a RAM ring that the DMA drains in the background.
+ * A message that does not fit is dropped and counted, and a note with the count is logged
+ * once there is room again.
+ *
+ * @param[in] fmt  printf-style format
+ * @param[in] argp Arguments of the format
+ */
 void vprint( const char* fmt, va_list argp );
 
+/**
+ * @brief Queue raw log bytes for the UART, e.g. a tokenized trace frame
+ *
+ * Same policy as vprint(): never blocks, the whole message is dropped if it does not fit.
+ *
+ * @param[in] data   Bytes to send
+ * @param[in] length Number of bytes
+ */
+void uart_log_write( const uint8_t* data, uint32_t length );
+
+/**
+ * @brief Number of log messages dropped because the ring was full
+ *
+ * @returns Messages dropped since start-up
+ */
+uint32_t uart_log_dropped( void );
+
+/**
+ * @brief Wait until every queued log message has been sent, e.g. before a reset or sleep
+ */
+void uart_log_flush( void );
+
 #ifdef __cplusplus
 }
 #endif
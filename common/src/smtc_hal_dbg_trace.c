@@ -38,16 +38,31 @@
  */
 
 #include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 #include <stdio.h>
 
 #include "uart_init.h"
+#include "smtc_hal_dbg_trace.h"
 
 /*
  * -----------------------------------------------------------------------------
  * --- PRIVATE MACROS-----------------------------------------------------------
  */
 
+/*!
+ * @brief Tokenized trace frame: [sync][level][token low][token high][length][payload]
+ *
+ * The payload holds the arguments in format order, little endian: integers as 4 bytes
+ * (8 for ll/j conversions), doubles as 8 bytes, pointers as 4 bytes and strings as their
+ * characters and a terminating NUL. Text never contains the sync byte, so the decoder can
+ * resynchronise and pass plain text through.
+ */
+#define TRACE_TOKEN_SYNC 0xA5
+#define TRACE_TOKEN_HEADER_SIZE 5
+#define TRACE_TOKEN_PAYLOAD_MAX 255
+
 /*
  * -----------------------------------------------------------------------------
  * --- PRIVATE CONSTANTS -------------------------------------------------------
@@ -63,11 +78,32 @@
  * --- PRIVATE VARIABLES -------------------------------------------------------
  */
 
+#if( HAL_DBG_TRACE_TOKENIZED == HAL_FEATURE_ON )
+/*!
+ * @brief Start of the format string section, provided by the linker
+ */
+extern const char __start_hal_trace_fmt[];
+#endif
+
 /*
  * -----------------------------------------------------------------------------
  * --- PRIVATE FUNCTIONS DECLARATION -------------------------------------------
  */
 
+#if( HAL_DBG_TRACE_TOKENIZED == HAL_FEATURE_ON )
+/**
+ * @brief Write the frame header for @p fmt and return the frame size so far
+ */
+static uint32_t trace_token_header( uint8_t* frame, uint8_t level, const char* fmt );
+
+/**
+ * @brief Pack the arguments of @p fmt into @p out, walking the conversions of the format
+ *
+ * @returns Number of bytes written, at most @p capacity (arguments that do not fit are cut)
+ */
+static uint32_t trace_token_pack( const char* fmt, va_list argp, uint8_t* out, uint32_t capacity );
+#endif
+
 /*
  * -----------------------------------------------------------------------------
  * --- PUBLIC FUNCTIONS DEFINITION ---------------------------------------------
@@ -81,9 +117,173 @@ void hal_mcu_trace_print( const char* fmt, ... )
     va_end( argp );
 }
 
+#if( HAL_DBG_TRACE_TOKENIZED == HAL_FEATURE_ON )
+void hal_mcu_trace_token( uint8_t level, const char* fmt, ... )
+{
+    uint8_t  frame[TRACE_TOKEN_HEADER_SIZE + TRACE_TOKEN_PAYLOAD_MAX];
+    uint32_t length = trace_token_header( frame, level, fmt );
+
+    va_list argp;
+    va_start( argp, fmt );
+    uint32_t payload = trace_token_pack( fmt, argp, frame + length, TRACE_TOKEN_PAYLOAD_MAX );
+    va_end( argp );
+
+    frame[length - 1] = ( uint8_t ) payload;
+    uart_log_write( frame, length + payload );
+}
+
+void hal_mcu_trace_token_array( uint8_t level, const char* msg, const uint8_t* array, uint32_t len )
+{
+    uint8_t  frame[TRACE_TOKEN_HEADER_SIZE + TRACE_TOKEN_PAYLOAD_MAX];
+    uint32_t length = trace_token_header( frame, level, msg );
+
+    if( len > TRACE_TOKEN_PAYLOAD_MAX )
+    {
+        len = TRACE_TOKEN_PAYLOAD_MAX;
+    }
+    memcpy( frame + length, array, len );
+    frame[length - 1] = ( uint8_t ) len;
+    uart_log_write( frame, length + len );
+}
+#endif
+
 /*
  * -----------------------------------------------------------------------------
  * --- PRIVATE FUNCTIONS DEFINITION --------------------------------------------
  */
 
+#if( HAL_DBG_TRACE_TOKENIZED == HAL_FEATURE_ON )
+static uint32_t trace_token_header( uint8_t* frame, uint8_t level, const char* fmt )
+{
+    uint16_t token = ( uint16_t ) ( fmt - __start_hal_trace_fmt );
+    frame[0]       = TRACE_TOKEN_SYNC;
+    frame[1]       = level;
+    frame[2]       = ( uint8_t ) token;
+    frame[3]       = ( uint8_t ) ( token >> 8 );
+    frame[4]       = 0;  // Payload length, filled in by the caller
+    return TRACE_TOKEN_HEADER_SIZE;
+}
+
+static uint32_t trace_token_pack( const char* fmt, va_list argp, uint8_t* out, uint32_t capacity )
+{
+    uint32_t length = 0;
+
+    for( const char* p = fmt; *p != '\0'; p++ )
+    {
+        if( *p != '%' )
+        {
+            continue;
+        }
+        p++;
+        if( *p == '%' )
+        {
+            continue;
+        }
+
+        // Flags, width and precision; '*' takes an int argument
+        while( *p != '\0' && strchr( "-+ #0123456789.*", *p ) != NULL )
+        {
+            if( *p == '*' && length + 4 <= capacity )
+            {
+                int32_t value = va_arg( argp, int );
+                memcpy( out + length, &value, 4 );
+                length += 4;
+            }
+            p++;
+        }
+
+        // Length modifiers: only ll and j change the size of an integer argument
+        bool wide = false;
+        while( *p != '\0' && strchr( "hlLqjzt", *p ) != NULL )
+        {
+            if( *p == 'j' || ( *p == 'l' && p[1] == 'l' ) )
+            {
+                wide = true;
+            }
+            p++;
+        }
+
+        uint8_t  buffer[8];
+        uint32_t size = 0;
+        switch( *p )
+        {
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+        case 'c':
+            if( wide )
+            {
+                uint64_t value = va_arg( argp, unsigned long long );
+                memcpy( buffer, &value, 8 );
+                size = 8;
+            }
+            else
+            {
+                uint32_t value = ( uint32_t ) va_arg( argp, unsigned long );
+                memcpy( buffer, &value, 4 );
+                size = 4;
+            }
+            break;
+        case 'p':
+        {
+            uint32_t value = ( uint32_t ) ( uintptr_t ) va_arg( argp, void* );
+            memcpy( buffer, &value, 4 );
+            size = 4;
+            break;
+        }
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+        {
+            double value = va_arg( argp, double );
+            memcpy( buffer, &value, 8 );
+            size = 8;
+            break;
+        }
+        case 's':
+        {
+            const char* string = va_arg( argp, const char* );
+            if( string == NULL )
+            {
+                string = "(null)";
+            }
+            size_t string_length = strlen( string ) + 1;
+            if( length + string_length > capacity )
+            {
+                return length;  // Cut: the decoder stops at the end of the payload
+            }
+            memcpy( out + length, string, string_length );
+            length += string_length;
+            break;
+        }
+        default:
+            return length;  // Unknown conversion: the remaining arguments cannot be walked
+        }
+
+        if( size > 0 )
+        {
+            if( length + size > capacity )
+            {
+                return length;
+            }
+            memcpy( out + length, buffer, size );
+            length += size;
+        }
+        if( *p == '\0' )
+        {
+            break;
+        }
+    }
+    return length;
+}
+#endif
+
 /* --- EOF ------------------------------------------------------------------ */
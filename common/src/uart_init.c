@@ -36,11 +36,15 @@
  * -----------------------------------------------------------------------------
  * --- DEPENDENCIES ------------------------------------------------------------
  */
+#include <stdbool.h>
 #include <stddef.h>
 #include <string.h>
 #include <stdio.h>
 #include "uart_init.h"
 #include "stm32l4xx.h"
+#include "stm32l4xx_ll_bus.h"
+#include "stm32l4xx_ll_dma.h"
+#include "stm32l4xx_ll_usart.h"
 #include "smtc_hal_mcu_uart_stm32l4.h"
 
 /*
@@ -53,6 +57,32 @@
  * --- PRIVATE CONSTANTS -------------------------------------------------------
  */
 
+/*!
+ * @brief Size of the RAM ring holding formatted log text until the DMA sends it
+ *
+ * Must be a power of two. At 921600 baud the UART drains about 92 bytes per millisecond.
+ */
+#ifndef UART_LOG_RING_SIZE
+#define UART_LOG_RING_SIZE 4096
+#endif
+
+#if( UART_LOG_RING_SIZE & ( UART_LOG_RING_SIZE - 1 ) ) != 0
+#error "UART_LOG_RING_SIZE must be a power of two"
+#endif
+
+/*!
+ * @brief Longest message formatted by a single vprint() call
+ */
+#define UART_LOG_MESSAGE_MAX 255
+
+/*!
+ * @brief DMA channel wired to USART2_TX (RM0351: DMA1 channel 7, request 2)
+ */
+#define UART_LOG_DMA DMA1
+#define UART_LOG_DMA_CHANNEL LL_DMA_CHANNEL_7
+#define UART_LOG_DMA_REQUEST LL_DMA_REQUEST_2
+#define UART_LOG_DMA_IRQN DMA1_Channel7_IRQn
+
 /*
  * -----------------------------------------------------------------------------
  * --- PRIVATE TYPES -----------------------------------------------------------
@@ -65,6 +95,19 @@
 
 static smtc_hal_mcu_uart_inst_t inst_uart = NULL;
 
+/*!
+ * @brief Log ring: vprint() appends at head, the DMA sends from tail
+ *
+ * Indexes run freely and are masked on access. Only vprint() (with interrupts masked) moves
+ * head, only the DMA interrupt moves tail.
+ */
+static uint8_t           log_ring[UART_LOG_RING_SIZE];
+static volatile uint32_t log_head        = 0;
+static volatile uint32_t log_tail        = 0;
+static volatile uint32_t log_dma_length  = 0;  // Bytes of the transfer in progress, 0 if idle
+static volatile uint32_t log_dropped     = 0;  // Messages discarded because the ring was full
+static uint32_t          log_dropped_seen = 0;  // log_dropped value already reported in the log
+
 /*
  * -----------------------------------------------------------------------------
  * --- PRIVATE FUNCTIONS DECLARATION -------------------------------------------
@@ -77,6 +120,25 @@ static smtc_hal_mcu_uart_inst_t inst_uart = NULL;
  */
 void uart_init_base( void ( *callback_rx )( uint8_t data ) );
 
+/**
+ * @brief Configure the DMA channel that drains the log ring into USART2
+ */
+static void uart_log_dma_init( void );
+
+/**
+ * @brief Start a DMA transfer of the next contiguous run of the ring, if idle and not empty
+ *
+ * Called with interrupts masked or from the DMA interrupt.
+ */
+static void uart_log_dma_kick( void );
+
+/**
+ * @brief Append bytes to the ring. Returns false if they do not fit.
+ *
+ * Called with interrupts masked.
+ */
+static bool uart_log_append( const uint8_t* data, uint32_t length );
+
 /*
  * -----------------------------------------------------------------------------
  * --- PUBLIC FUNCTIONS DEFINITION ---------------------------------------------
@@ -94,10 +156,66 @@ void uart_init_with_rx_callback( void ( *callback_rx )( uint8_t data ) )
 
 void vprint( const char* fmt, va_list argp )
 {
-    char string[255];
-    if( 0 < vsprintf( string, fmt, argp ) )  // build string
+    char string[UART_LOG_MESSAGE_MAX + 1];
+    int  length = vsnprintf( string, sizeof( string ), fmt, argp );  // build string
+    if( length <= 0 )
+    {
+        return;
+    }
+    if( length > UART_LOG_MESSAGE_MAX )
+    {
+        length = UART_LOG_MESSAGE_MAX;  // Truncated
+    }
+    uart_log_write( ( const uint8_t* ) string, ( uint32_t ) length );
+}
+
+void uart_log_write( const uint8_t* data, uint32_t length )
+{
+    // Never wait for the UART: a message that does not fit is dropped and counted
+    uint32_t primask = __get_PRIMASK( );
+    __disable_irq( );
+    if( log_dropped != log_dropped_seen )
     {
-        smtc_hal_mcu_uart_send( inst_uart, ( uint8_t* ) string, strlen( string ) );
+        char note[48];
+        int  note_length = snprintf( note, sizeof( note ), "\r\n[log: %lu message(s) dropped]\r\n",
+                                     ( unsigned long ) ( log_dropped - log_dropped_seen ) );
+        if( ( uint32_t ) note_length + ( uint32_t ) length <= UART_LOG_RING_SIZE - ( log_head - log_tail ) )
+        {
+            uart_log_append( ( const uint8_t* ) note, ( uint32_t ) note_length );
+            log_dropped_seen = log_dropped;
+        }
+    }
+    if( !uart_log_append( data, length ) )
+    {
+        log_dropped++;
+    }
+    uart_log_dma_kick( );
+    __set_PRIMASK( primask );
+}
+
+uint32_t uart_log_dropped( void )
+{
+    return log_dropped;
+}
+
+void uart_log_flush( void )
+{
+    while( log_head != log_tail )
+    {
+    }
+}
+
+/**
+ * @brief DMA transfer complete: release the bytes sent and send the next run
+ */
+void DMA1_Channel7_IRQHandler( void )
+{
+    if( LL_DMA_IsActiveFlag_TC7( UART_LOG_DMA ) )
+    {
+        LL_DMA_ClearFlag_TC7( UART_LOG_DMA );
+        log_tail += log_dma_length;
+        log_dma_length = 0;
+        uart_log_dma_kick( );
     }
 }
 
@@ -116,6 +234,69 @@ void uart_init_base( void ( *callback_rx )( uint8_t data ) )
         .callback_rx = callback_rx,
     };
     smtc_hal_mcu_uart_init( ( const smtc_hal_mcu_uart_cfg_t ) &cfg_uart, &uart_cfg_app, &inst_uart );
+    uart_log_dma_init( );
+}
+
+static void uart_log_dma_init( void )
+{
+    LL_AHB1_GRP1_EnableClock( LL_AHB1_GRP1_PERIPH_DMA1 );
+
+    LL_DMA_SetPeriphRequest( UART_LOG_DMA, UART_LOG_DMA_CHANNEL, UART_LOG_DMA_REQUEST );
+    LL_DMA_ConfigTransfer( UART_LOG_DMA, UART_LOG_DMA_CHANNEL,
+                           LL_DMA_DIRECTION_MEMORY_TO_PERIPH | LL_DMA_PRIORITY_LOW | LL_DMA_MODE_NORMAL |
+                               LL_DMA_PERIPH_NOINCREMENT | LL_DMA_MEMORY_INCREMENT | LL_DMA_PDATAALIGN_BYTE |
+                               LL_DMA_MDATAALIGN_BYTE );
+    LL_DMA_SetPeriphAddress( UART_LOG_DMA, UART_LOG_DMA_CHANNEL,
+                             LL_USART_DMA_GetRegAddr( USART2, LL_USART_DMA_REG_DATA_TRANSMIT ) );
+    LL_DMA_EnableIT_TC( UART_LOG_DMA, UART_LOG_DMA_CHANNEL );
+
+    // Below the radio DIO interrupt: logging must never delay RX_DONE
+    NVIC_SetPriority( UART_LOG_DMA_IRQN, 0x0F );
+    NVIC_EnableIRQ( UART_LOG_DMA_IRQN );
+
+    LL_USART_EnableDMAReq_TX( USART2 );
+}
+
+static void uart_log_dma_kick( void )
+{
+    uint32_t pending = log_head - log_tail;
+    if( log_dma_length != 0 || pending == 0 )
+    {
+        return;
+    }
+
+    // One contiguous run: up to the end of the ring, the rest goes in the next transfer
+    uint32_t start  = log_tail & ( UART_LOG_RING_SIZE - 1 );
+    uint32_t length = UART_LOG_RING_SIZE - start;
+    if( length > pending )
+    {
+        length = pending;
+    }
+    log_dma_length = length;
+
+    LL_DMA_DisableChannel( UART_LOG_DMA, UART_LOG_DMA_CHANNEL );
+    LL_DMA_SetMemoryAddress( UART_LOG_DMA, UART_LOG_DMA_CHANNEL, ( uint32_t ) &log_ring[start] );
+    LL_DMA_SetDataLength( UART_LOG_DMA, UART_LOG_DMA_CHANNEL, length );
+    LL_DMA_EnableChannel( UART_LOG_DMA, UART_LOG_DMA_CHANNEL );
+}
+
+static bool uart_log_append( const uint8_t* data, uint32_t length )
+{
+    if( length > UART_LOG_RING_SIZE - ( log_head - log_tail ) )
+    {
+        return false;
+    }
+
+    uint32_t start = log_head & ( UART_LOG_RING_SIZE - 1 );
+    uint32_t first = UART_LOG_RING_SIZE - start;
+    if( first > length )
+    {
+        first = length;
+    }
+    memcpy( &log_ring[start], data, first );
+    memcpy( log_ring, data + first, length - first );
+    log_head += length;
+    return true;
 }
 
 /* --- EOF ------------------------------------------------------------------ */
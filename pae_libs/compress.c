@@ -0,0 +1,220 @@
+#include "compress.h"
+#include "pae_profile.h"
+
+#include <string.h>
+
+static bool compress_enabled[NUM_PORTS];
+
+void compress_set_port(uint8_t PortID, bool enabled) {
+    if (PortID < NUM_PORTS) {
+        compress_enabled[PortID] = enabled;
+    }
+}
+
+bool compress_port_enabled(uint8_t PortID) {
+    return PortID < NUM_PORTS && compress_enabled[PortID];
+}
+
+static inline uint32_t lz_read32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t lz_hash(const uint8_t *p) {
+    return (lz_read32(p) * 2654435761u) >> (32 - LZ_HASH_BITS); // Fibonacci hashing
+}
+
+// Write a length above the 15 held by the token as bytes of 255 and a final remainder
+static uint8_t *lz_put_length(uint8_t *op, const uint8_t *oend, size_t length) {
+    while (length >= 255) {
+        if (op >= oend) {
+            return NULL;
+        }
+        *op++ = 255;
+        length -= 255;
+    }
+    if (op >= oend) {
+        return NULL;
+    }
+    *op++ = (uint8_t)length;
+    return op;
+}
+
+// Emit one sequence: literals [anchor, anchor + literals) then, if match_length > 0, the match
+static uint8_t *lz_put_sequence(uint8_t *op, const uint8_t *oend, const uint8_t *anchor, size_t literals,
+    size_t offset, size_t match_length) {
+    if (op >= oend) {
+        return NULL;
+    }
+    size_t match_code = (match_length > 0) ? match_length - LZ_MIN_MATCH : 0;
+    uint8_t *token = op++;
+    *token = (uint8_t)(((literals < 15) ? literals : 15) << 4 | ((match_code < 15) ? match_code : 15));
+    if (literals >= 15 && (op = lz_put_length(op, oend, literals - 15)) == NULL) {
+        return NULL;
+    }
+    if ((size_t)(oend - op) < literals) {
+        return NULL;
+    }
+    memcpy(op, anchor, literals);
+    op += literals;
+    if (match_length == 0) {
+        return op;
+    }
+
+    if (oend - op < 2) {
+        return NULL;
+    }
+    *op++ = (uint8_t)offset;
+    *op++ = (uint8_t)(offset >> 8);
+    if (match_code >= 15 && (op = lz_put_length(op, oend, match_code - 15)) == NULL) {
+        return NULL;
+    }
+    return op;
+}
+
+size_t lz_compress(const uint8_t *src, size_t length, uint8_t *dst, size_t capacity) {
+    static uint16_t table[1u << LZ_HASH_BITS]; // Last position seen for each hash
+    if (src == NULL || dst == NULL || length == 0 || length > LZ_MAX_OFFSET + 1) {
+        return 0;
+    }
+    memset(table, 0, sizeof(table));
+
+    const uint8_t *ip = src;
+    const uint8_t *anchor = src;
+    const uint8_t *end = src + length;
+    const uint8_t *match_limit = (length >= LZ_MIN_MATCH) ? end - LZ_MIN_MATCH : src;
+    uint8_t *op = dst;
+    uint8_t *oend = dst + capacity;
+
+    while (ip < match_limit) {
+        uint32_t h = lz_hash(ip);
+        const uint8_t *candidate = src + table[h];
+        table[h] = (uint16_t)(ip - src);
+        if (candidate >= ip || lz_read32(candidate) != lz_read32(ip)) {
+            ip++;
+            continue;
+        }
+
+        const uint8_t *mp = ip + LZ_MIN_MATCH;
+        const uint8_t *cp = candidate + LZ_MIN_MATCH;
+        while (mp < end && *mp == *cp) {
+            mp++;
+            cp++;
+        }
+        op = lz_put_sequence(op, oend, anchor, (size_t)(ip - anchor), (size_t)(ip - candidate), (size_t)(mp - ip));
+        if (op == NULL) {
+            return 0;
+        }
+        // Index the end of the match so the next repeat is found
+        if (mp - 2 > ip && mp - 2 < match_limit) {
+            table[lz_hash(mp - 2)] = (uint16_t)(mp - 2 - src);
+        }
+        ip = anchor = mp;
+    }
+
+    if (anchor < end || op == dst) {
+        op = lz_put_sequence(op, oend, anchor, (size_t)(end - anchor), 0, 0);
+        if (op == NULL) {
+            return 0;
+        }
+    }
+    return (size_t)(op - dst);
+}
+
+// Read a length extension; false if it runs past the block
+static bool lz_get_length(const uint8_t **ip, const uint8_t *iend, size_t *length) {
+    uint8_t b;
+    do {
+        if (*ip >= iend) {
+            return false;
+        }
+        b = *(*ip)++;
+        *length += b;
+    } while (b == 255);
+    return true;
+}
+
+size_t lz_decompress(const uint8_t *src, size_t length, uint8_t *dst, size_t capacity) {
+    if (src == NULL || dst == NULL || length == 0) {
+        return 0;
+    }
+    const uint8_t *ip = src;
+    const uint8_t *iend = src + length;
+    uint8_t *op = dst;
+
+    while (ip < iend) {
+        uint8_t token = *ip++;
+        size_t literals = token >> 4;
+        if (literals == 15 && !lz_get_length(&ip, iend, &literals)) {
+            return 0;
+        }
+        if ((size_t)(iend - ip) < literals || capacity - (size_t)(op - dst) < literals) {
+            return 0;
+        }
+        memcpy(op, ip, literals);
+        ip += literals;
+        op += literals;
+        if (ip == iend) {
+            break; // Last sequence
+        }
+
+        if (iend - ip < 2) {
+            return 0;
+        }
+        size_t offset = ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        size_t match_length = token & 0x0F;
+        if (match_length == 15 && !lz_get_length(&ip, iend, &match_length)) {
+            return 0;
+        }
+        match_length += LZ_MIN_MATCH;
+        if (offset == 0 || offset > (size_t)(op - dst) || capacity - (size_t)(op - dst) < match_length) {
+            return 0;
+        }
+        // Byte by byte: the match may overlap the bytes it produces (runs)
+        const uint8_t *mp = op - offset;
+        for (size_t i = 0; i < match_length; i++) {
+            op[i] = mp[i];
+        }
+        op += match_length;
+    }
+    return (size_t)(op - dst);
+}
+
+size_t compress_pack(const uint8_t *payload, size_t length, uint8_t *dst, size_t capacity) {
+    if (payload == NULL || dst == NULL || length == 0 || capacity < length + SIZE_COMPRESS_ENVELOPE) {
+        return 0;
+    }
+    PAE_PROFILE_SCOPE(PAE_PROBE_COMPRESS_PACK);
+    PAE_PROFILE_BYTES(length);
+    // Only keep the block if it is shorter than the raw payload
+    size_t packed = lz_compress(payload, length, dst + SIZE_COMPRESS_ENVELOPE, length - 1);
+    if (packed > 0) {
+        dst[0] = COMPRESS_LZ;
+        return SIZE_COMPRESS_ENVELOPE + packed;
+    }
+    dst[0] = COMPRESS_NONE;
+    memcpy(dst + SIZE_COMPRESS_ENVELOPE, payload, length);
+    return SIZE_COMPRESS_ENVELOPE + length;
+}
+
+const uint8_t *compress_unpack(const uint8_t *packet, size_t length, uint8_t *dst, size_t capacity,
+    size_t *payload_length) {
+    if (packet == NULL || payload_length == NULL || length <= SIZE_COMPRESS_ENVELOPE) {
+        return NULL;
+    }
+    const uint8_t *body = packet + SIZE_COMPRESS_ENVELOPE;
+    size_t body_length = length - SIZE_COMPRESS_ENVELOPE;
+    if (packet[0] == COMPRESS_NONE) {
+        *payload_length = body_length;
+        return body;
+    }
+    if (packet[0] == COMPRESS_LZ) {
+        PAE_PROFILE_SCOPE(PAE_PROBE_COMPRESS_UNPACK); // Raw payloads cost nothing to open
+        *payload_length = lz_decompress(body, body_length, dst, capacity);
+        PAE_PROFILE_BYTES(*payload_length);
+        return (*payload_length > 0) ? dst : NULL;
+    }
+    return NULL; // Unknown encoding
+}
@@ -0,0 +1,53 @@
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+#include "protocol_definitions.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Optional payload compression in front of segmentation.
+// On ports where it is enabled every packet starts with a one-byte envelope telling the
+// receiver how the rest was encoded, so incompressible packets still go out raw. Both ends
+// must enable the same ports.
+#define COMPRESS_NONE 0x00 // Payload follows unchanged
+#define COMPRESS_LZ 0x01   // Payload follows as an LZ block (see lz_compress())
+#define SIZE_COMPRESS_ENVELOPE 1
+
+#ifndef COMPRESS_MAX_PACKET_SIZE
+#define COMPRESS_MAX_PACKET_SIZE 4096 // Largest payload the receiver can expand
+#endif
+
+// LZ block format (LZ4-like, byte aligned). A block is a list of sequences:
+//   [token][literal length ext...][literals][offset lo][offset hi][match length ext...]
+// The token holds the literal count (high nibble) and the match length minus LZ_MIN_MATCH
+// (low nibble); 15 means more length follows in bytes of 255 plus a final byte < 255.
+// The last sequence stops after its literals. The encoder keeps one table of
+// 2^LZ_HASH_BITS positions; the decoder needs no memory besides its output.
+#ifndef LZ_HASH_BITS
+#define LZ_HASH_BITS 10 // 1024 entries, 2 KiB of RAM
+#endif
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_OFFSET 0xFFFF
+
+void compress_set_port(uint8_t PortID, bool enabled);
+bool compress_port_enabled(uint8_t PortID);
+
+// Compress `length` bytes into `dst`. Returns the block size, or 0 if it would not fit in
+// `capacity` bytes.
+size_t lz_compress(const uint8_t *src, size_t length, uint8_t *dst, size_t capacity);
+
+// Expand a block into `dst`. Returns the expanded size, or 0 if the block is malformed or
+// does not fit in `capacity` bytes.
+size_t lz_decompress(const uint8_t *src, size_t length, uint8_t *dst, size_t capacity);
+
+// Envelope the payload for sending: compressed when that makes it smaller, raw otherwise.
+// Returns the size written to `dst`, or 0 if `capacity` is below length + 1.
+size_t compress_pack(const uint8_t *payload, size_t length, uint8_t *dst, size_t capacity);
+
+// Open an enveloped payload. A raw payload is returned as a view into `packet`; a compressed
+// one is expanded into `dst`. Returns NULL if the envelope is invalid.
+const uint8_t *compress_unpack(const uint8_t *packet, size_t length, uint8_t *dst, size_t capacity,
+    size_t *payload_length);
+
+#endif // COMPRESS_H
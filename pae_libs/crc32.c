@@ -0,0 +1,106 @@
+#include "crc32.h"
+#include "pae_profile.h"
+
+#include <stdbool.h>
+
+#if CRC32_HW
+#include "stm32l4xx.h"
+
+static bool crc_hw_ready = false;
+
+void crc32_init(void) {
+    RCC->AHB1ENR |= RCC_AHB1ENR_CRCEN;
+    (void)RCC->AHB1ENR; // Wait for the clock to reach the peripheral
+    CRC->POL = CRC32_POLY;
+    CRC->CR = 0; // 32-bit polynomial, no input or output bit reversal
+    crc_hw_ready = true;
+}
+
+uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t len) {
+    if (!crc_hw_ready) {
+        crc32_init(); // An unclocked peripheral would return the same value for every frame
+    }
+    PAE_PROFILE_SCOPE(PAE_PROBE_CRC32);
+    PAE_PROFILE_BYTES(len);
+    CRC->INIT = crc;
+    CRC->CR |= CRC_CR_RESET; // Load INIT into the data register
+
+    // Whole words first: with no input reversal the peripheral takes the MSB first,
+    // so the word is assembled big-endian to match the byte order on air
+    while (len >= 4) {
+        CRC->DR = ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
+        data += 4;
+        len -= 4;
+    }
+    while (len > 0) {
+        *(volatile uint8_t *)&CRC->DR = *data++;
+        len--;
+    }
+    return CRC->DR;
+}
+
+#else
+static uint32_t crc_table[8][256]; // Slice-by-8 tables (8 KiB)
+static bool crc_table_ready = false;
+
+void crc32_init(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i << 24;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80000000u) ? (crc << 1) ^ CRC32_POLY : (crc << 1);
+        }
+        crc_table[0][i] = crc;
+    }
+    // Table k advances a byte that is followed by k zero bytes
+    for (uint32_t i = 0; i < 256; i++) {
+        for (int k = 1; k < 8; k++) {
+            uint32_t prev = crc_table[k - 1][i];
+            crc_table[k][i] = (prev << 8) ^ crc_table[0][prev >> 24];
+        }
+    }
+    crc_table_ready = true;
+}
+
+uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t len) {
+    if (!crc_table_ready) {
+        crc32_init();
+    }
+    PAE_PROFILE_SCOPE(PAE_PROBE_CRC32);
+    PAE_PROFILE_BYTES(len);
+
+    // Eight bytes per step
+    while (len >= 8) {
+        uint32_t one = crc ^ (((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) |
+                              ((uint32_t)data[2] << 8) | data[3]);
+        uint32_t two = ((uint32_t)data[4] << 24) | ((uint32_t)data[5] << 16) |
+                       ((uint32_t)data[6] << 8) | data[7];
+        crc = crc_table[7][one >> 24] ^ crc_table[6][(one >> 16) & 0xFF] ^
+              crc_table[5][(one >> 8) & 0xFF] ^ crc_table[4][one & 0xFF] ^
+              crc_table[3][two >> 24] ^ crc_table[2][(two >> 16) & 0xFF] ^
+              crc_table[1][(two >> 8) & 0xFF] ^ crc_table[0][two & 0xFF];
+        data += 8;
+        len -= 8;
+    }
+    // Remaining bytes one at a time
+    while (len > 0) {
+        crc = (crc << 8) ^ crc_table[0][(crc >> 24) ^ *data++];
+        len--;
+    }
+    return crc;
+}
+#endif
+
+bool crc32_self_test(void) {
+    static const uint8_t check[] = "123456789";
+    const size_t len = sizeof(check) - 1;
+    if (crc32_compute(check, len) != CRC32_CHECK) {
+        return false;
+    }
+    for (size_t split = 0; split <= len; split++) {
+        uint32_t crc = crc32_update(CRC32_INIT, check, split);
+        if (crc32_update(crc, check + split, len - split) != CRC32_CHECK) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,42 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// CRC-32 of the Proximity-1 frame check sequence:
+// G(x) = x^32 + x^23 + x^21 + x^11 + x^2 + 1, MSB first, register preset to zero, no final XOR.
+#define CRC32_POLY 0x00A00805u
+#define CRC32_INIT 0x00000000u
+
+// Backend selection: the STM32L4 CRC peripheral on target, slice-by-8 tables elsewhere.
+// Override with -DCRC32_HW=0 or -DCRC32_HW=1.
+#ifndef CRC32_HW
+#if defined(__arm__)
+#define CRC32_HW 1
+#else
+#define CRC32_HW 0
+#endif
+#endif
+
+// Build the tables or enable and configure the peripheral. Call once at start-up; the
+// first crc32_update() also does it if needed.
+void crc32_init(void);
+
+// Continue a CRC over `len` more bytes. The hardware backend is not reentrant:
+// do not use it from an interrupt while the main loop is computing a CRC.
+uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t len);
+
+static inline uint32_t crc32_compute(const uint8_t *data, size_t len) {
+    return crc32_update(CRC32_INIT, data, len);
+}
+
+// CRC of the ASCII string "123456789", the usual check value of a CRC parameter set
+#define CRC32_CHECK 0x51693C0Cu
+
+// Known-answer test of the active backend: the check value in one call, then the same bytes
+// split at every offset (word and tail paths). Run it after crc32_init() on target.
+bool crc32_self_test(void);
+
+#endif // CRC32_H
@@ -0,0 +1,247 @@
+#include "dataser_sublayer.h"
+#include "io_sublayer.h"
+
+#include <string.h>
+#include <stdio.h>
+
+static PDUHeader* frame_header(SDUFrame *frame) {
+    return (frame->type == FRAME_FRAGMENTED) ? &frame->data.fragmented.pdu_header : &frame->data.unfragmented.header;
+}
+
+// FOP-P
+
+void fop_p_init(FOPSender *fop) {
+    memset(fop, 0, sizeof(FOPSender));
+}
+
+bool fop_p_window_open(const FOPSender *fop) {
+    return fop->count < COP_WINDOW_SIZE;
+}
+
+bool fop_p_accept(FOPSender *fop, const SDUFrame *frame) {
+    if (!fop_p_window_open(fop)) {
+        return false; // Window full, wait for a PLCW
+    }
+
+    SDUFrame *slot = &fop->window[(fop->head + fop->count) % COP_WINDOW_SIZE];
+    *slot = *frame;
+    PDUHeader *header = frame_header(slot);
+    header->QoS = SEQUENCED_CONTROLLEED;
+    header->FSN = fop->vs++;
+    fop->count++;
+    return true;
+}
+
+bool fop_p_next(FOPSender *fop, SDUFrame *out, uint32_t now_ms) {
+    if (fop->next_to_send >= fop->count) {
+        return false; // Everything in the window is on air
+    }
+
+    *out = fop->window[(fop->head + fop->next_to_send) % COP_WINDOW_SIZE];
+    if (fop->next_to_send < fop->sent_once) {
+        fop->retransmissions++;
+    } else {
+        fop->sent_once++;
+        fop->frames_sent++;
+    }
+    fop->next_to_send++;
+    fop->timer_ms = now_ms;
+    return true;
+}
+
+size_t fop_p_process_plcw(FOPSender *fop, const PLCW *plcw, uint32_t now_ms) {
+    // N(R) must lie between N(N)R and V(S): anything else is a stale or corrupt report
+    uint8_t acked = (uint8_t)(plcw->report_value - fop->nnr);
+    if (acked > fop->sent_once) {
+        fprintf(stderr, "Error: PLCW report value outside the window.\n");
+        return 0;
+    }
+
+    // Release the acknowledged frames
+    fop->head = (uint8_t)((fop->head + acked) % COP_WINDOW_SIZE);
+    fop->count -= acked;
+    fop->sent_once -= acked;
+    fop->next_to_send = (fop->next_to_send > acked) ? (uint8_t)(fop->next_to_send - acked) : 0;
+    fop->nnr = plcw->report_value;
+    fop->acknowledged += acked;
+    if (acked > 0) {
+        fop->retries = 0;
+        fop->timer_ms = now_ms;
+    }
+
+    // Go-back-N: resend everything from N(R)
+    if (plcw->retransmit && fop->count > 0) {
+        fop->next_to_send = 0;
+    }
+    return acked;
+}
+
+bool fop_p_poll(FOPSender *fop, uint32_t now_ms) {
+    if (fop->sent_once == 0 || fop->next_to_send < fop->sent_once) {
+        return false; // Nothing waiting for an acknowledgement, or a resend is under way
+    }
+    if ((uint32_t)(now_ms - fop->timer_ms) < COP_RETRANSMIT_TIMEOUT_MS) {
+        return false;
+    }
+    fop->next_to_send = 0;
+    fop->timer_ms = now_ms;
+    fop->timeouts++;
+    if (fop->retries < UINT8_MAX) {
+        fop->retries++;
+    }
+    return true;
+}
+
+bool fop_p_idle(const FOPSender *fop) {
+    return fop->count == 0;
+}
+
+bool fop_p_failed(const FOPSender *fop) {
+    return fop->retries >= COP_MAX_RETRIES;
+}
+
+void fop_p_resume(FOPSender *fop, uint32_t now_ms) {
+    fop->retries = 0;
+    fop->next_to_send = 0;
+    fop->timer_ms = now_ms;
+}
+
+// FARM-P
+
+void farm_p_init(FARMReceiver *farm) {
+    memset(farm, 0, sizeof(FARMReceiver));
+}
+
+bool farm_p_receive(FARMReceiver *farm, const SDUFrame *frame) {
+    const PDUHeader *header = (frame->type == FRAME_FRAGMENTED) ? &frame->data.fragmented.pdu_header
+                                                                 : &frame->data.unfragmented.header;
+    if (header->QoS == EXPEDITED) {
+        farm->expedited_count = (farm->expedited_count + 1) & PLCW_EXPEDITED_MASK;
+        return true;
+    }
+
+    farm->plcw_pending = true; // Every Sequence Controlled frame gets a report
+    uint8_t offset = (uint8_t)(header->FSN - farm->vr);
+    if (offset == 0) {
+        farm->vr++;
+        farm->retransmit = false;
+        farm->accepted++;
+        return true;
+    }
+    if (offset < 128) {
+        farm->retransmit = true; // Frames were lost before this one
+        farm->out_of_order++;
+    } else {
+        farm->duplicates++; // Already accepted, the sender missed our PLCW
+    }
+    return false;
+}
+
+// Wrap a supervisory PDU in an Expedited PDU_COMMAND frame
+static SDUFrame spdu_frame(uint8_t *spdu, uint16_t length, uint16_t SC_ID, uint8_t SD_ID) {
+    SDUFrame frame = {0};
+    frame.type = FRAME_UNFRAGMENTED;
+    frame.data.unfragmented.header = create_pdu_header(VERSION_3, EXPEDITED, PDU_COMMAND, DFC_PACKETS, SC_ID,
+        PRIMARYCANAL, 0, SD_ID, length, 0);
+    frame.data.unfragmented.sdu = spdu;
+    return frame;
+}
+
+// SDU of a PDU_COMMAND frame whose SPDU type and length match, or NULL
+static const uint8_t* spdu_payload(const SDUFrame *frame, uint8_t type, uint16_t length) {
+    if (frame->type != FRAME_UNFRAGMENTED || frame->data.unfragmented.header.PDU_ID != PDU_COMMAND ||
+        frame->data.unfragmented.sdu == NULL) {
+        return NULL;
+    }
+    const PDUHeader *header = &frame->data.unfragmented.header;
+    uint16_t sdu_length = ((uint16_t)header->data_length_high << 8) | header->data_length_low;
+    const uint8_t *spdu = frame->data.unfragmented.sdu;
+    if (sdu_length != length || spdu[0] != type) {
+        return NULL;
+    }
+    return spdu;
+}
+
+SDUFrame farm_p_plcw_frame(FARMReceiver *farm, uint16_t SC_ID, uint8_t SD_ID) {
+    PLCW plcw = {farm->vr, farm->retransmit, PRIMARYCANAL, farm->expedited_count};
+    plcw_encode(&plcw, farm->plcw_spdu);
+    farm->plcw_pending = false;
+    return spdu_frame(farm->plcw_spdu, SIZE_PLCW_SPDU, SC_ID, SD_ID);
+}
+
+// PLCW coding
+
+void plcw_encode(const PLCW *plcw, uint8_t spdu[SIZE_PLCW_SPDU]) {
+    spdu[0] = SPDU_TYPE_PLCW;
+    spdu[1] = (uint8_t)((plcw->retransmit ? PLCW_RETRANSMIT_MASK : 0) | ((plcw->pcid & 0x01) << PLCW_PCID_SHIFT) |
+                        ((plcw->expedited_count & PLCW_EXPEDITED_MASK) << PLCW_EXPEDITED_SHIFT));
+    spdu[2] = plcw->report_value;
+}
+
+bool plcw_from_frame(const SDUFrame *frame, PLCW *out) {
+    const uint8_t *spdu = spdu_payload(frame, SPDU_TYPE_PLCW, SIZE_PLCW_SPDU);
+    if (spdu == NULL) {
+        return false;
+    }
+    out->retransmit = (spdu[1] & PLCW_RETRANSMIT_MASK) != 0;
+    out->pcid = (spdu[1] >> PLCW_PCID_SHIFT) & 0x01;
+    out->expedited_count = (spdu[1] >> PLCW_EXPEDITED_SHIFT) & PLCW_EXPEDITED_MASK;
+    out->report_value = spdu[2];
+    return true;
+}
+
+// NACK coding
+
+void nack_encode(const NACKReport *nack, uint8_t spdu[SIZE_NACK_SPDU]) {
+    spdu[0] = SPDU_TYPE_NACK;
+    spdu[1] = nack->pseudo_packet_id;
+    memcpy(spdu + 2, nack->missing, NACK_BITMAP_BYTES);
+}
+
+bool nack_from_frame(const SDUFrame *frame, NACKReport *out) {
+    const uint8_t *spdu = spdu_payload(frame, SPDU_TYPE_NACK, SIZE_NACK_SPDU);
+    if (spdu == NULL) {
+        return false;
+    }
+    out->pseudo_packet_id = spdu[1];
+    memcpy(out->missing, spdu + 2, NACK_BITMAP_BYTES);
+    return true;
+}
+
+SDUFrame nack_frame(const NACKReport *nack, uint8_t storage[SIZE_NACK_SPDU], uint16_t SC_ID, uint8_t SD_ID) {
+    nack_encode(nack, storage);
+    return spdu_frame(storage, SIZE_NACK_SPDU, SC_ID, SD_ID);
+}
+
+bool nack_is_missing(const NACKReport *nack, size_t index) {
+    if (index >= NACK_BITMAP_BYTES * 8) {
+        return false;
+    }
+    return (nack->missing[index / 8] >> (index % 8)) & 0x01;
+}
+
+// Metrics coding
+
+bool metrics_frame(uint8_t storage[SIZE_METRICS_SPDU_MAX], uint16_t SC_ID, uint8_t SD_ID, SDUFrame *out) {
+    storage[0] = SPDU_TYPE_METRICS;
+    size_t length = pae_metrics_snapshot(storage + 1, SIZE_METRICS_SPDU_MAX - 1);
+    if (length == 0) {
+        return false;
+    }
+    *out = spdu_frame(storage, (uint16_t)(length + 1), SC_ID, SD_ID);
+    return true;
+}
+
+bool metrics_from_frame(const SDUFrame *frame, PaeMetrics *out) {
+    if (frame->type != FRAME_UNFRAGMENTED || frame->data.unfragmented.header.PDU_ID != PDU_COMMAND ||
+        frame->data.unfragmented.sdu == NULL) {
+        return false;
+    }
+    const PDUHeader *header = &frame->data.unfragmented.header;
+    uint16_t sdu_length = ((uint16_t)header->data_length_high << 8) | header->data_length_low;
+    const uint8_t *spdu = frame->data.unfragmented.sdu;
+    if (sdu_length < 2 || spdu[0] != SPDU_TYPE_METRICS) {
+        return false;
+    }
+    return pae_metrics_parse(spdu + 1, sdu_length - 1, out);
+}
@@ -2,8 +2,149 @@
 #define DATASER_SUBLAYER_H
 
 #include "protocol_definitions.h"
+#include "io_sublayer.h"
+#include "pae_metrics.h"
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdlib.h>
 
-#endif // DATASER_SUBLAYER_H
\ No newline at end of file
+// Data services sublayer: COP-P (Communication Operation Procedure for Proximity links).
+// FOP-P on the sender numbers Sequence Controlled frames with V(S) and keeps them in a
+// go-back-N window until a PLCW acknowledges them. FARM-P on the receiver accepts only the
+// frame whose FSN equals V(R) and reports V(R) back in a PLCW.
+
+#ifndef COP_WINDOW_SIZE
+#define COP_WINDOW_SIZE 8 // Frames sent and not yet acknowledged
+#endif
+#ifndef COP_RETRANSMIT_TIMEOUT_MS
+#define COP_RETRANSMIT_TIMEOUT_MS 3000 // Resend the window if no PLCW arrives for this long
+#endif
+#ifndef COP_MAX_RETRIES
+#define COP_MAX_RETRIES 5 // Consecutive timeouts before the link is reported as failed
+#endif
+#ifndef COP_PLCW_DELAY_MS
+#define COP_PLCW_DELAY_MS 300 // Receiver: send the PLCW after this long without a new frame
+#endif
+
+#if COP_WINDOW_SIZE < 1 || COP_WINDOW_SIZE > 127
+#error "COP_WINDOW_SIZE must be between 1 and 127 (half the FSN space)"
+#endif
+
+// Supervisory PDUs travel as PDU_COMMAND frames; the first SDU byte is the SPDU type
+#define SPDU_TYPE_PLCW 0x00 // Proximity Link Control Word
+#define SPDU_TYPE_NACK 0x01 // Missing segments of an Expedited packet
+#define SPDU_TYPE_METRICS 0x02 // Snapshot of the sender's pae_metrics registry
+#define SIZE_PLCW_SPDU 3    // [type][flags][report value]
+#define SIZE_METRICS_SPDU_MAX MAX_UNFRAGMENTED_SDU_SIZE // [type][pae_metrics_snapshot()]
+
+// Selective repeat for Expedited fragmented packets: the receiver reports the missing
+// segments of a stalled packet as a bitmap and the sender resends only those.
+#define NACK_BITMAP_BYTES ((REASSEMBLY_MAX_SEGMENTS + 7) / 8)
+#define SIZE_NACK_SPDU (2 + NACK_BITMAP_BYTES) // [type][PseudoPacketID][bitmap]
+#ifndef NACK_DELAY_MS
+#define NACK_DELAY_MS 500 // Receiver: report a packet after this long without a new segment
+#endif
+#ifndef NACK_WAIT_MS
+#define NACK_WAIT_MS 3000 // Sender: keep the packet this long after the last (re)transmission
+#endif
+#ifndef NACK_MAX_ROUNDS
+#define NACK_MAX_ROUNDS 3 // Sender: repair rounds before the packet is released
+#endif
+
+// PLCW flags byte: [reserved(3) | expedited frame counter(3) | PCID(1) | retransmit(1)]
+#define PLCW_RETRANSMIT_MASK 0x01
+#define PLCW_PCID_SHIFT 1
+#define PLCW_EXPEDITED_SHIFT 2
+#define PLCW_EXPEDITED_MASK 0x07
+
+typedef struct {
+    uint8_t report_value;     // V(R): FSN of the next frame the receiver expects
+    bool retransmit;          // Receiver saw a gap and asks for the frames from V(R)
+    uint8_t pcid;             // Physical channel of the report
+    uint8_t expedited_count;  // Expedited frames received, modulo 8
+} PLCW;
+
+typedef struct {
+    uint8_t pseudo_packet_id; // Packet the report refers to
+    uint8_t missing[NACK_BITMAP_BYTES]; // Bit n (LSB first) set: segment n is missing
+} NACKReport;
+
+typedef struct {
+    SDUFrame window[COP_WINDOW_SIZE]; // Sent queue, oldest first (frames borrowed, SDUs not owned)
+    uint8_t head;             // Slot of the oldest unacknowledged frame
+    uint8_t count;            // Frames in the window
+    uint8_t next_to_send;     // Frames of the window already (re)transmitted in this pass
+    uint8_t sent_once;        // Frames of the window transmitted at least once
+    uint8_t vs;               // V(S): FSN given to the next new frame
+    uint8_t nnr;              // N(N)R: FSN of the oldest unacknowledged frame
+    uint8_t retries;          // Consecutive timeouts without progress
+    uint32_t timer_ms;        // Time of the last transmission or progress
+    uint32_t frames_sent;     // New frames transmitted
+    uint32_t retransmissions; // Frames transmitted again
+    uint32_t acknowledged;    // Frames released by a PLCW
+    uint32_t timeouts;        // Retransmissions started by the timer
+} FOPSender;
+
+typedef struct {
+    uint8_t vr;               // V(R): FSN of the next frame to accept
+    bool retransmit;          // A gap was seen since the last in-order frame
+    uint8_t expedited_count;  // Expedited frames received, modulo 8
+    bool plcw_pending;        // State changed since the last PLCW
+    uint8_t plcw_spdu[SIZE_PLCW_SPDU]; // Storage for the PLCW frame SDU
+    uint32_t accepted;        // Sequence Controlled frames delivered
+    uint32_t duplicates;      // Frames already accepted, discarded
+    uint32_t out_of_order;    // Frames after a gap, discarded
+} FARMReceiver;
+
+// FOP-P (sender)
+void fop_p_init(FOPSender *fop);
+// True if the window can take another frame
+bool fop_p_window_open(const FOPSender *fop);
+// Take a frame into the window: it becomes Sequence Controlled with FSN = V(S).
+// The frame is copied but its SDU is borrowed: the SDU must stay valid until the frame is
+// acknowledged, even after free_buffer() and across cycles if the window outlives a failure.
+// False if the window is full.
+bool fop_p_accept(FOPSender *fop, const SDUFrame *frame);
+// Next frame to put on air (new or being resent); false when there is nothing to send
+bool fop_p_next(FOPSender *fop, SDUFrame *out, uint32_t now_ms);
+// Process a PLCW from the receiver. Returns the number of frames it acknowledged.
+size_t fop_p_process_plcw(FOPSender *fop, const PLCW *plcw, uint32_t now_ms);
+// Run the retransmission timer. Returns true if the window is being resent.
+bool fop_p_poll(FOPSender *fop, uint32_t now_ms);
+// True when every accepted frame has been acknowledged
+bool fop_p_idle(const FOPSender *fop);
+// True after COP_MAX_RETRIES timeouts in a row
+bool fop_p_failed(const FOPSender *fop);
+// Give a failed sender another COP_MAX_RETRIES timeouts. The window is kept and resent from N(N)R.
+void fop_p_resume(FOPSender *fop, uint32_t now_ms);
+
+// FARM-P (receiver)
+void farm_p_init(FARMReceiver *farm);
+// Run a received frame through FARM-P. Returns true if it must be delivered upwards.
+// Expedited frames are always delivered.
+bool farm_p_receive(FARMReceiver *farm, const SDUFrame *frame);
+// Build the PLCW frame reporting the current state. The SDU points into `farm`.
+SDUFrame farm_p_plcw_frame(FARMReceiver *farm, uint16_t SC_ID, uint8_t SD_ID);
+
+// PLCW coding
+void plcw_encode(const PLCW *plcw, uint8_t spdu[SIZE_PLCW_SPDU]);
+// True if `frame` is a PLCW SPDU; the decoded fields go to `out`
+bool plcw_from_frame(const SDUFrame *frame, PLCW *out);
+
+// NACK coding
+void nack_encode(const NACKReport *nack, uint8_t spdu[SIZE_NACK_SPDU]);
+// True if `frame` is a NACK SPDU; the decoded report goes to `out`
+bool nack_from_frame(const SDUFrame *frame, NACKReport *out);
+// Build the NACK frame for `nack`. The SDU points into `storage`.
+SDUFrame nack_frame(const NACKReport *nack, uint8_t storage[SIZE_NACK_SPDU], uint16_t SC_ID, uint8_t SD_ID);
+// True if segment `index` is marked missing
+bool nack_is_missing(const NACKReport *nack, size_t index);
+
+// Metrics coding
+// Build a frame carrying a snapshot of pae_metrics. The SDU points into `storage`.
+// False if the snapshot does not fit in one frame.
+bool metrics_frame(uint8_t storage[SIZE_METRICS_SPDU_MAX], uint16_t SC_ID, uint8_t SD_ID, SDUFrame *out);
+// True if `frame` is a metrics SPDU; the decoded snapshot goes to `out`
+bool metrics_from_frame(const SDUFrame *frame, PaeMetrics *out);
+
+#endif // DATASER_SUBLAYER_H
@@ -0,0 +1,191 @@
+#include "fec.h"
+#include "gf256.h"
+#include "pae_profile.h"
+
+#include <string.h>
+
+#if FEC_PARITY > 0
+static uint8_t generator[FEC_PARITY + 1]; // g(x), generator[0] is the x^FEC_PARITY coefficient (1)
+static bool fec_ready = false;
+
+void fec_init(void) {
+    if (fec_ready) {
+        return;
+    }
+    gf256_init();
+
+    // g(x) = prod (x - alpha^(RS_PRIM * (RS_FCR + i)))
+    memset(generator, 0, sizeof(generator));
+    generator[0] = 1;
+    for (int i = 0; i < FEC_PARITY; i++) {
+        uint8_t root = gf256_alpha_pow((uint32_t)RS_PRIM * (RS_FCR + i));
+        for (int j = i + 1; j > 0; j--) {
+            generator[j] ^= gf256_mul(generator[j - 1], root);
+        }
+    }
+    fec_ready = true;
+}
+
+size_t fec_encode(uint8_t *frame, size_t length, size_t capacity) {
+    PAE_PROFILE_SCOPE(PAE_PROBE_FEC_ENCODE);
+    if (frame == NULL || length == 0 || length + FEC_PARITY > capacity || length + FEC_PARITY > 255) {
+        return 0; // Does not fit in one codeword
+    }
+    PAE_PROFILE_BYTES(length);
+    fec_init();
+
+    // Systematic encoding: parity = frame(x) * x^FEC_PARITY mod g(x), by LFSR division
+    uint8_t *parity = frame + length;
+    memset(parity, 0, FEC_PARITY);
+    for (size_t i = 0; i < length; i++) {
+        uint8_t feedback = frame[i] ^ parity[0];
+        memmove(parity, parity + 1, FEC_PARITY - 1);
+        parity[FEC_PARITY - 1] = 0;
+        if (feedback != 0) {
+            for (int j = 0; j < FEC_PARITY; j++) {
+                parity[j] ^= gf256_mul(feedback, generator[j + 1]);
+            }
+        }
+    }
+    return length + FEC_PARITY;
+}
+
+// Evaluate the codeword at x = alpha^exponent, byte 0 being the highest degree
+static uint8_t syndrome(const uint8_t *codeword, size_t length, uint32_t exponent) {
+    uint8_t x = gf256_alpha_pow(exponent);
+    uint8_t s = 0;
+    for (size_t i = 0; i < length; i++) {
+        s = gf256_mul(s, x) ^ codeword[i];
+    }
+    return s;
+}
+
+// Evaluate a polynomial stored lowest degree first
+static uint8_t poly_eval(const uint8_t *poly, int degree, uint8_t x) {
+    uint8_t y = 0;
+    for (int i = degree; i >= 0; i--) {
+        y = gf256_mul(y, x) ^ poly[i];
+    }
+    return y;
+}
+
+int fec_decode(uint8_t *codeword, size_t length, size_t *frame_length) {
+    PAE_PROFILE_SCOPE(PAE_PROBE_FEC_DECODE);
+    if (codeword == NULL || length <= FEC_PARITY || length > 255) {
+        return -1;
+    }
+    PAE_PROFILE_BYTES(length);
+    fec_init();
+    if (frame_length != NULL) {
+        *frame_length = length - FEC_PARITY;
+    }
+
+    uint8_t s[FEC_PARITY];
+    bool clean = true;
+    for (int i = 0; i < FEC_PARITY; i++) {
+        s[i] = syndrome(codeword, length, (uint32_t)RS_PRIM * (RS_FCR + i));
+        clean = clean && (s[i] == 0);
+    }
+    if (clean) {
+        return 0;
+    }
+
+    // Berlekamp-Massey: error locator lambda(x), lowest degree first
+    uint8_t lambda[FEC_PARITY + 1] = {1};
+    uint8_t prev[FEC_PARITY + 1] = {1};
+    uint8_t tmp[FEC_PARITY + 1];
+    int errors = 0;
+    int shift = 1;
+    uint8_t prev_discrepancy = 1;
+    for (int n = 0; n < FEC_PARITY; n++) {
+        uint8_t d = s[n];
+        for (int i = 1; i <= errors; i++) {
+            d ^= gf256_mul(lambda[i], s[n - i]);
+        }
+        if (d == 0) {
+            shift++;
+            continue;
+        }
+        uint8_t scale = gf256_div(d, prev_discrepancy);
+        memcpy(tmp, lambda, sizeof(lambda));
+        for (int i = 0; i + shift <= FEC_PARITY; i++) {
+            lambda[i + shift] ^= gf256_mul(scale, prev[i]);
+        }
+        if (2 * errors <= n) {
+            errors = n + 1 - errors;
+            memcpy(prev, tmp, sizeof(prev));
+            prev_discrepancy = d;
+            shift = 1;
+        } else {
+            shift++;
+        }
+    }
+    if (errors > FEC_MAX_CORRECTABLE) {
+        return -1;
+    }
+
+    // Error evaluator omega(x) = s(x) * lambda(x) mod x^FEC_PARITY
+    uint8_t omega[FEC_PARITY] = {0};
+    for (int i = 0; i < FEC_PARITY; i++) {
+        for (int j = 0; j <= errors && j <= i; j++) {
+            omega[i] ^= gf256_mul(s[i - j], lambda[j]);
+        }
+    }
+
+    // Chien search over the transmitted positions, then Forney for the error values.
+    // Byte i carries the coefficient of x^(length - 1 - i); its locator is alpha^(RS_PRIM * degree).
+    int found = 0;
+    uint8_t positions[FEC_MAX_CORRECTABLE];
+    uint8_t values[FEC_MAX_CORRECTABLE];
+    for (size_t degree = 0; degree < length && found <= errors; degree++) {
+        uint32_t log_locator = (uint32_t)(RS_PRIM * degree) % 255;
+        uint8_t locator_inv = gf256_exp[255 - log_locator];
+        if (poly_eval(lambda, errors, locator_inv) != 0) {
+            continue;
+        }
+        if (found == errors) {
+            return -1; // More roots than the degree: not a valid locator
+        }
+
+        // lambda'(x): only the odd terms survive in characteristic 2
+        uint8_t derivative = 0;
+        for (int i = 1; i <= errors; i += 2) {
+            derivative ^= gf256_mul(lambda[i], gf256_exp[((255 - log_locator) * (uint32_t)(i - 1)) % 255]);
+        }
+        if (derivative == 0) {
+            return -1;
+        }
+        // Y = X^(1 - RS_FCR) * omega(X^-1) / lambda'(X^-1)
+        uint8_t numerator = gf256_mul(poly_eval(omega, FEC_PARITY - 1, locator_inv),
+            gf256_exp[(log_locator * (uint32_t)(255 + 1 - (RS_FCR % 255))) % 255]);
+        positions[found] = (uint8_t)(length - 1 - degree);
+        values[found] = gf256_div(numerator, derivative);
+        found++;
+    }
+    if (found != errors) {
+        return -1; // Some roots fall outside the codeword: uncorrectable
+    }
+
+    for (int i = 0; i < found; i++) {
+        codeword[positions[i]] ^= values[i];
+    }
+    return found;
+}
+
+#else
+void fec_init(void) {
+}
+
+size_t fec_encode(uint8_t *frame, size_t length, size_t capacity) {
+    (void)frame;
+    return (length <= capacity) ? length : 0;
+}
+
+int fec_decode(uint8_t *codeword, size_t length, size_t *frame_length) {
+    (void)codeword;
+    if (frame_length != NULL) {
+        *frame_length = length;
+    }
+    return 0;
+}
+#endif
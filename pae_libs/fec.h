@@ -0,0 +1,35 @@
+#ifndef FEC_H
+#define FEC_H
+
+#include "protocol_definitions.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Reed-Solomon forward error correction between the frame sublayer and the radio.
+// Each LoRa packet is one shortened RS codeword: the serialized frame followed by
+// FEC_PARITY parity bytes, which correct up to FEC_PARITY / 2 corrupted bytes.
+// The parity count (code rate) is set in protocol_definitions.h.
+// Generator roots follow CCSDS: alpha^(RS_PRIM * (RS_FCR + i)), i = 0 .. FEC_PARITY - 1.
+#ifndef RS_FCR
+#define RS_FCR 112 // First consecutive root
+#endif
+#ifndef RS_PRIM
+#define RS_PRIM 11 // Primitive element used to step between roots
+#endif
+
+#define FEC_MAX_CORRECTABLE (FEC_PARITY / 2)
+
+// Build the field tables and the generator polynomial. Call once at start-up.
+void fec_init(void);
+
+// Append the parity bytes to `frame` in place. `capacity` is the size of the buffer.
+// Returns the length to transmit, or 0 if the frame does not fit.
+size_t fec_encode(uint8_t *frame, size_t length, size_t capacity);
+
+// Correct a received codeword of `length` bytes in place. Returns the number of bytes
+// corrected (0 if it was clean) and stores the frame length without parity in
+// `frame_length`, or -1 if the errors are beyond the correction capacity.
+int fec_decode(uint8_t *codeword, size_t length, size_t *frame_length);
+
+#endif // FEC_H
@@ -1,10 +1,41 @@
 #include "frame_sublayer.h"
 #include "protocol_definitions.h"
 #include "io_sublayer.h"
+#include "sdu_pool.h"
+#include "pdu_codec.h"
+#include "crc32.h"
+#include "pae_metrics.h"
+#include "pae_profile.h"
 
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+// Frame check sequence: CRC-32 over headers and SDU, stored big-endian after the SDU
+static void append_fcs(uint8_t* frame, size_t length) {
+#if FCS_ENABLED
+    uint32_t crc = crc32_compute(frame, length);
+    frame[length] = (uint8_t)(crc >> 24);
+    frame[length + 1] = (uint8_t)(crc >> 16);
+    frame[length + 2] = (uint8_t)(crc >> 8);
+    frame[length + 3] = (uint8_t)crc;
+#else
+    (void)frame;
+    (void)length;
+#endif
+}
+
+static bool check_fcs(const uint8_t* frame, size_t length) {
+#if FCS_ENABLED
+    uint32_t crc = ((uint32_t)frame[length] << 24) | ((uint32_t)frame[length + 1] << 16) |
+                   ((uint32_t)frame[length + 2] << 8) | frame[length + 3];
+    return crc32_compute(frame, length) == crc;
+#else
+    (void)frame;
+    (void)length;
+    return true;
+#endif
+}
+
 // Data transmission
 // Serialize the SDU
 SerializedData serialize_sdu_frame(const SDUFrame* frame) {
@@ -14,17 +45,15 @@ SerializedData serialize_sdu_frame(const SDUFrame* frame) {
 
     // Calculate the SDU length according to the frame type
     if (frame->type == FRAME_UNFRAGMENTED) {
-        sdu_length = ((uint32_t)frame->data.unfragmented.header.data_length_high << 8) | 
-                     frame->data.unfragmented.header.data_length_low;
-        total_length = sizeof(PDUHeader) + sdu_length;
+        sdu_length = pdu_header_data_length(&frame->data.unfragmented.header);
+        total_length = SIZE_PDU_HEADER + sdu_length + SIZE_FCS;
     } else { // FRAGMENTED
-        sdu_length = ((uint32_t)frame->data.fragmented.pdu_header.data_length_high << 8) | 
-                     frame->data.fragmented.pdu_header.data_length_low;
-        total_length = sizeof(PDUHeader) + sizeof(SegmentationHeader) + sdu_length;
+        sdu_length = pdu_header_data_length(&frame->data.fragmented.pdu_header);
+        total_length = SIZE_PDU_HEADER + SIZE_SEGMENTATION_HEADER + sdu_length + SIZE_FCS;
     }
 
-    // Allocate memory for the buffer
-    result.data = (uint8_t*)malloc(total_length);
+    // Take a block from the SDU pool for the serialized frame
+    result.data = sdu_pool_alloc(total_length);
     if (!result.data) {
         return result; // Failure: data=NULL, length=0
     }
@@ -32,24 +61,26 @@ SerializedData serialize_sdu_frame(const SDUFrame* frame) {
 
     uint32_t offset = 0;
 
-    // Copy headers and SDU according to the type
+    // Encode headers and copy the SDU according to the type
     if (frame->type == FRAME_UNFRAGMENTED) {
-        memcpy(result.data + offset, &frame->data.unfragmented.header, sizeof(PDUHeader));
-        offset += sizeof(PDUHeader);
+        pdu_header_encode(&frame->data.unfragmented.header, result.data + offset);
+        offset += SIZE_PDU_HEADER;
         memcpy(result.data + offset, frame->data.unfragmented.sdu, sdu_length);
     } else {
-        memcpy(result.data + offset, &frame->data.fragmented.pdu_header, sizeof(PDUHeader));
-        offset += sizeof(PDUHeader);
-        memcpy(result.data + offset, &frame->data.fragmented.seg_header, sizeof(SegmentationHeader));
-        offset += sizeof(SegmentationHeader);
+        pdu_header_encode(&frame->data.fragmented.pdu_header, result.data + offset);
+        offset += SIZE_PDU_HEADER;
+        result.data[offset] = seg_header_encode(&frame->data.fragmented.seg_header);
+        offset += SIZE_SEGMENTATION_HEADER;
         memcpy(result.data + offset, frame->data.fragmented.sdu, sdu_length);
     }
+    append_fcs(result.data, total_length - SIZE_FCS);
 
     return result;
 }
 
 // Serialize SDU frame into a caller-provided buffer (no malloc)
 size_t serialize_into(const SDUFrame* frame, uint8_t* buffer, size_t buffer_size) {
+    PAE_PROFILE_SCOPE(PAE_PROBE_SERIALIZE_INTO);
     if (!frame || !buffer || buffer_size == 0) {
         return 0; // Invalid input
     }
@@ -59,13 +90,11 @@ size_t serialize_into(const SDUFrame* frame, uint8_t* buffer, size_t buffer_size
 
     // Calculate the SDU length according to the frame type
     if (frame->type == FRAME_UNFRAGMENTED) {
-        sdu_length = ((uint32_t)frame->data.unfragmented.header.data_length_high << 8) | 
-                     frame->data.unfragmented.header.data_length_low;
-        total_length = sizeof(PDUHeader) + sdu_length;
+        sdu_length = pdu_header_data_length(&frame->data.unfragmented.header);
+        total_length = SIZE_PDU_HEADER + sdu_length + SIZE_FCS;
     } else { // FRAGMENTED
-        sdu_length = ((uint32_t)frame->data.fragmented.pdu_header.data_length_high << 8) | 
-                     frame->data.fragmented.pdu_header.data_length_low;
-        total_length = sizeof(PDUHeader) + sizeof(SegmentationHeader) + sdu_length;
+        sdu_length = pdu_header_data_length(&frame->data.fragmented.pdu_header);
+        total_length = SIZE_PDU_HEADER + SIZE_SEGMENTATION_HEADER + sdu_length + SIZE_FCS;
     }
 
     // Check if buffer is large enough
@@ -75,170 +104,157 @@ size_t serialize_into(const SDUFrame* frame, uint8_t* buffer, size_t buffer_size
 
     uint32_t offset = 0;
 
-    // Copy headers and SDU according to the type
+    // Encode headers and copy the SDU according to the type
     if (frame->type == FRAME_UNFRAGMENTED) {
-        memcpy(buffer + offset, &frame->data.unfragmented.header, sizeof(PDUHeader));
-        offset += sizeof(PDUHeader);
+        pdu_header_encode(&frame->data.unfragmented.header, buffer + offset);
+        offset += SIZE_PDU_HEADER;
         memcpy(buffer + offset, frame->data.unfragmented.sdu, sdu_length);
     } else {
-        memcpy(buffer + offset, &frame->data.fragmented.pdu_header, sizeof(PDUHeader));
-        offset += sizeof(PDUHeader);
-        memcpy(buffer + offset, &frame->data.fragmented.seg_header, sizeof(SegmentationHeader));
-        offset += sizeof(SegmentationHeader);
+        pdu_header_encode(&frame->data.fragmented.pdu_header, buffer + offset);
+        offset += SIZE_PDU_HEADER;
+        buffer[offset] = seg_header_encode(&frame->data.fragmented.seg_header);
+        offset += SIZE_SEGMENTATION_HEADER;
         memcpy(buffer + offset, frame->data.fragmented.sdu, sdu_length);
     }
+    append_fcs(buffer, total_length - SIZE_FCS);
+    PAE_PROFILE_BYTES(total_length);
 
     return total_length;
 }
-// Choose the priority of the data to send
-void choose_priority(SDUFrame** MultiplexedData, int* count, SDUFrame newData) {
-    if (*MultiplexedData == NULL || *count == 0) {
-        *MultiplexedData = (SDUFrame*)malloc(sizeof(SDUFrame));
-        if (*MultiplexedData == NULL) {
-            printf("Memory error\n");
-            return;
-        }
-        (*MultiplexedData)[0] = newData;
-        *count = 1;
-    } else {
-        int pos = 0;
-        if(newData.type == FRAME_FRAGMENTED){
-            pos = *count;
-        }else{
-            if(newData.data.unfragmented.header.PDU_ID == PDU_COMMAND){
-                for(int i = 0; i<*count;i++){
-                    if((*MultiplexedData)[i].data.unfragmented.header.PDU_ID == PDU_DATA){
-                        pos = i;
-                        break;
-                    }
-                }
-            }else if(newData.data.unfragmented.header.PDU_ID == PDU_DATA){
-                pos = *count;
-            }
-        }
+// Frame scheduler
+#define SCHED_MASK (SCHED_QUEUE_DEPTH - 1)
 
-        SDUFrame* aux = (SDUFrame*)malloc(sizeof(SDUFrame) * (*count + 1));
-        if (aux == NULL) {
-            printf("Memory error\n");
-            return;
-        }
-
-        // Copy data CHEKEAR OPTIMIZACION
-        for (int i = 0; i < pos; i++) {
-            aux[i] = (*MultiplexedData)[i];
-        }
-        aux[pos] = newData;
-        for (int i = pos; i < *count; i++) {
-            aux[i + 1] = (*MultiplexedData)[i];
-        }
+void scheduler_init(FrameScheduler* scheduler) {
+    memset(scheduler, 0, sizeof(FrameScheduler));
+    pae_metrics_queue_depth(0);
+}
 
-        free(*MultiplexedData);
-        *MultiplexedData = aux;
-        (*count)++;
+SchedClass scheduler_class_of(const SDUFrame* frame) {
+    const PDUHeader* header = (frame->type == FRAME_FRAGMENTED) ? &frame->data.fragmented.pdu_header
+                                                                 : &frame->data.unfragmented.header;
+    if (header->PDU_ID == PDU_COMMAND) {
+        return SCHED_CLASS_COMMAND;
     }
+    return (header->QoS == EXPEDITED) ? SCHED_CLASS_EXPEDITED : SCHED_CLASS_SEQUENCED;
 }
 
-bool check_data(SDUFrame** MultiplexedData, int* count) {
-    if (*MultiplexedData == NULL || *count == 0) {
-        return false; // No multiplexed data
+bool scheduler_enqueue(FrameScheduler* scheduler, const SDUFrame* frame, uint32_t now_ms) {
+    SchedQueue* queue = &scheduler->queues[scheduler_class_of(frame)];
+    uint16_t depth = (uint16_t)(queue->tail - queue->head);
+    if (depth == SCHED_QUEUE_DEPTH) {
+        queue->stats.dropped++;
+        return false; // Ring full
     }
-    return true; // There is multiplexed data
-}
-// Send the first data from the multiplexed data list
-SerializedData send_to_LoRa(SDUFrame** MultiplexedData, int* count) {
-    static uint8_t txbuf[MAX_TOTAL_FRAME_SIZE]; // Static buffer (no malloc)
-    SerializedData to_send = {NULL, 0};
-    SerializedData empty = {NULL, 0};
-    if (*count == 0) {
-        return empty; // No data to send
+
+    SchedEntry* entry = &queue->entries[queue->tail & SCHED_MASK];
+    entry->frame = *frame;
+    entry->enqueued_ms = now_ms;
+    queue->tail++;
+
+    queue->stats.enqueued++;
+    queue->stats.depth = depth + 1u;
+    if (queue->stats.depth > queue->stats.high_water) {
+        queue->stats.high_water = queue->stats.depth;
     }
+    pae_metrics_queue_depth(scheduler_depth(scheduler));
+    return true;
+}
 
-    // Serialize the first SDUFrame into static buffer
-    size_t tx_len = serialize_into((*MultiplexedData), txbuf, sizeof(txbuf));
-    if (tx_len == 0) {
-        return empty; // Serialization error
+bool scheduler_dequeue(FrameScheduler* scheduler, SDUFrame* out, uint32_t now_ms) {
+    SchedEntry entry;
+    if (!scheduler_dequeue_entry(scheduler, &entry, now_ms)) {
+        return false;
     }
-    to_send.data = txbuf;
-    to_send.length = tx_len;
-
-    // Free the payload of the SDUFrame that we've serialized
-    // send_to_LoRa removes the first element from *MultiplexedData, so
-    // we must free its owned sdu memory here to avoid leaks.
-    SDUFrame first_frame = (*MultiplexedData)[0];
-    if (first_frame.type == FRAME_UNFRAGMENTED) {
-        if (first_frame.data.unfragmented.sdu) {
-            free(first_frame.data.unfragmented.sdu);
+    *out = entry.frame;
+    return true;
+}
+
+bool scheduler_dequeue_entry(FrameScheduler* scheduler, SchedEntry* out, uint32_t now_ms) {
+    for (size_t c = 0; c < SCHED_NUM_CLASSES; c++) {
+        SchedQueue* queue = &scheduler->queues[c];
+        if (queue->head == queue->tail) {
+            continue; // Nothing waiting in this class
         }
-    } else if (first_frame.type == FRAME_FRAGMENTED) {
-        if (first_frame.data.fragmented.sdu) {
-            free(first_frame.data.fragmented.sdu);
+
+        SchedEntry* entry = &queue->entries[queue->head & SCHED_MASK];
+        *out = *entry;
+        queue->head++;
+
+        uint32_t wait = now_ms - entry->enqueued_ms;
+        queue->stats.dequeued++;
+        queue->stats.depth--;
+        queue->stats.total_wait_ms += wait;
+        if (wait > queue->stats.max_wait_ms) {
+            queue->stats.max_wait_ms = wait;
         }
+        pae_metrics_queue_depth(scheduler_depth(scheduler));
+        return true;
     }
+    return false;
+}
 
-    // If only one element remains, free and update
-    if (*count == 1) {
-    if (*MultiplexedData != NULL) {
-        free(*MultiplexedData);
+size_t scheduler_send_into(FrameScheduler* scheduler, uint8_t* buffer, size_t buffer_size, uint32_t now_ms) {
+    SDUFrame frame;
+    if (!scheduler_dequeue(scheduler, &frame, now_ms)) {
+        return 0; // No data to send
     }
-    *MultiplexedData = NULL;
-    *count = 0;
-    return to_send;
+    return serialize_into(&frame, buffer, buffer_size);
 }
 
-    // Shift the remaining elements left by one in-place to avoid an extra allocation.
-    // This performs a single memmove of (N-1) elements instead of malloc/copy/free.
-    memmove(*MultiplexedData, (*MultiplexedData) + 1, sizeof(SDUFrame) * ((*count) - 1));
-    (*count)--;
+size_t scheduler_depth(const FrameScheduler* scheduler) {
+    size_t depth = 0;
+    for (size_t c = 0; c < SCHED_NUM_CLASSES; c++) {
+        depth += scheduler->queues[c].stats.depth;
+    }
+    return depth;
+}
 
-   
+size_t scheduler_space(const FrameScheduler* scheduler, SchedClass sched_class) {
+    if ((unsigned)sched_class >= SCHED_NUM_CLASSES) {
+        return 0;
+    }
+    const SchedQueue* queue = &scheduler->queues[sched_class];
+    return SCHED_QUEUE_DEPTH - (uint16_t)(queue->tail - queue->head);
+}
 
-    return to_send;
+SchedQueueStats scheduler_get_stats(const FrameScheduler* scheduler, SchedClass sched_class) {
+    SchedQueueStats empty = {0};
+    if ((unsigned)sched_class >= SCHED_NUM_CLASSES) {
+        return empty;
+    }
+    return scheduler->queues[sched_class].stats;
 }
 
 
 // Data reception
 // Create the SDUFrame from the byte sequence
 SDUFrame deserialize_sdu_frame(const uint8_t* data) {
+    PAE_PROFILE_SCOPE(PAE_PROBE_DESERIALIZE_SDU_FRAME);
     SDUFrame frame = {0};
     if (!data) {
         return frame; // Error: null data
     }
 
-    // Store the first 5 bytes in the PDU header
+    // Decode the first 5 bytes into the PDU header
     PDUHeader pdu_header;
-     // Byte 0
-     //uint8_t aux = data[0];
-     pdu_header.VersionNum = data[0] & 0x03;               // bits 0-1
-     pdu_header.QoS        = (data[0] >> 2) & 0x01;         // bit 2
-     pdu_header.PDU_ID     = (data[0] >> 3) & 0x01;         // bit 3
-     pdu_header.DFC_ID     = (data[0] >> 4) & 0x03;         // bits 4-5
-     pdu_header.SC_ID_part1= (data[0] >> 6) & 0x03;         // bits 6-7
- 
-     // Byte 1
-     pdu_header.SC_ID_part2 = data[1];                     // 8 direct bits
- 
-     // Byte 2
-     pdu_header.PC_ID           = data[2] & 0x01;           // bit 0
-     pdu_header.PortID          = (data[2] >> 1) & 0x07;     // bits 1-3
-     pdu_header.SD_ID           = (data[2] >> 4) & 0x01;     // bit 4
-     pdu_header.data_length_high = (data[2] >> 5) & 0x07;    // bits 5-7
- 
-     // Byte 3
-     pdu_header.data_length_low = data[3];                 // 8 direct bits
- 
-     // Byte 4
-     pdu_header.FSN = data[4];                             // 8 direct bits
+    pdu_header_decode(data, &pdu_header);
 
     // Calculate the SDU length; it will only be the low 8 bits since LoRa limits the size and larger packets will not arrive
     uint8_t sdu_length = pdu_header.data_length_low;
 
+    // Drop the frame if the check sequence does not match
+    size_t header_length = SIZE_PDU_HEADER + (pdu_header.DFC_ID == DFC_FRAGMENTED ? SIZE_SEGMENTATION_HEADER : 0);
+    PAE_PROFILE_BYTES(header_length + sdu_length + SIZE_FCS);
+    if (!check_fcs(data, header_length + sdu_length)) {
+        return frame; // Error: corrupted frame
+    }
+
     // Check if the SDU is fragmented or not
     if(pdu_header.DFC_ID == DFC_FRAGMENTED) {
         frame.type = FRAME_FRAGMENTED;
         frame.data.fragmented.pdu_header = pdu_header;
-        frame.data.fragmented.seg_header.SegFlag = (data[5] & 0x03); // bits 0-1
-        frame.data.fragmented.seg_header.PseudoPacketID = (data[5] >> 2) & 0x3F; // bits 2-7
-        frame.data.fragmented.sdu = (uint8_t*)malloc(sdu_length);
+        seg_header_decode(data[SIZE_PDU_HEADER], &frame.data.fragmented.seg_header);
+        frame.data.fragmented.sdu = sdu_pool_alloc(sdu_length);
         if (!frame.data.fragmented.sdu) {
             return frame; // Error: memory failure
         }
@@ -246,7 +262,7 @@ SDUFrame deserialize_sdu_frame(const uint8_t* data) {
     } else {
         frame.type = FRAME_UNFRAGMENTED;
         frame.data.unfragmented.header = pdu_header;
-        frame.data.unfragmented.sdu = (uint8_t*)malloc(sdu_length);
+        frame.data.unfragmented.sdu = sdu_pool_alloc(sdu_length);
         if (!frame.data.unfragmented.sdu) {
             return frame; // Error: memory failure
         }
@@ -256,7 +272,61 @@ SDUFrame deserialize_sdu_frame(const uint8_t* data) {
     return frame;
 }
 
-bool check_sdu_frame(const SDUFrame* frame) {
+static bool parse_frame(uint8_t* data, size_t size, SDUFrame* out) {
+    SDUFrame frame = {0};
+    *out = frame;
+    if (data == NULL || size < SIZE_PDU_HEADER) {
+        return false; // Too short for a PDU header
+    }
+
+    PDUHeader pdu_header;
+    pdu_header_decode(data, &pdu_header);
+    if (pdu_header.VersionNum != VERSION_3) {
+        return false; // Not a Proximity-1 version 3 frame
+    }
+
+    size_t header_length = SIZE_PDU_HEADER;
+    if (pdu_header.DFC_ID == DFC_FRAGMENTED) {
+        header_length += SIZE_SEGMENTATION_HEADER;
+    }
+    size_t sdu_length = pdu_header_data_length(&pdu_header);
+    if (sdu_length == 0 || size < header_length + SIZE_FCS || size - header_length - SIZE_FCS < sdu_length) {
+        return false; // Data length does not match the received bytes
+    }
+    if (!check_fcs(data, header_length + sdu_length)) {
+        return false; // Corrupted frame
+    }
+
+    if (pdu_header.DFC_ID == DFC_FRAGMENTED) {
+        frame.type = FRAME_FRAGMENTED;
+        frame.data.fragmented.pdu_header = pdu_header;
+        seg_header_decode(data[SIZE_PDU_HEADER], &frame.data.fragmented.seg_header);
+        frame.data.fragmented.sdu = data + header_length;
+    } else {
+        frame.type = FRAME_UNFRAGMENTED;
+        frame.data.unfragmented.header = pdu_header;
+        frame.data.unfragmented.sdu = data + header_length;
+    }
+
+    *out = frame;
+    return true;
+}
+
+bool parse_sdu_frame(uint8_t* data, size_t size, SDUFrame* out) {
+    PAE_PROFILE_SCOPE(PAE_PROBE_PARSE_SDU_FRAME);
+    PAE_PROFILE_BYTES(size);
+    if (!parse_frame(data, size, out)) {
+        pae_metrics_invalid_frame();
+        return false;
+    }
+    const PDUHeader* header = (out->type == FRAME_FRAGMENTED) ? &out->data.fragmented.pdu_header
+                                                               : &out->data.unfragmented.header;
+    size_t header_length = SIZE_PDU_HEADER + (out->type == FRAME_FRAGMENTED ? SIZE_SEGMENTATION_HEADER : 0);
+    pae_metrics_rx_frame(header->PortID, header_length + pdu_header_data_length(header) + SIZE_FCS);
+    return true;
+}
+
+static bool check_frame(const SDUFrame* frame) {
     if (!frame) {
         return false; // Error: null frame
     }
@@ -275,4 +345,12 @@ bool check_sdu_frame(const SDUFrame* frame) {
     }
     
     return true; // Valid SDUFrame
-}
\ No newline at end of file
+}
+
+bool check_sdu_frame(const SDUFrame* frame) {
+    if (!check_frame(frame)) {
+        pae_metrics_invalid_frame();
+        return false;
+    }
+    return true;
+}
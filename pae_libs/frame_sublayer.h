@@ -7,12 +7,80 @@
 #include <stdbool.h>
 #include <stdlib.h>
 
+// The returned data is an SDU pool block, release it with sdu_pool_free()
 SerializedData serialize_sdu_frame(const SDUFrame* frame);
 size_t serialize_into(const SDUFrame* frame, uint8_t* buffer, size_t buffer_size);
-void choose_priority(SDUFrame** MultiplexedData, int* count, SDUFrame newData);
-bool check_data(SDUFrame** MultiplexedData, int* count);
-SerializedData send_to_LoRa(SDUFrame** MultiplexedData, int* count);
+
+// Frame scheduler: one ring per traffic class, served in strict priority order
+// (commands, then expedited data, then sequence-controlled data), FIFO within a class.
+// Frames are stored by value and the scheduler never frees their SDUs: whoever enqueued a
+// frame keeps the ownership it had (a view from get_packet_frames() stays with the IOBuffer,
+// a frame from move_to_next_sublayer() stays with the caller) and releases it after sending.
+#ifndef SCHED_QUEUE_DEPTH
+#define SCHED_QUEUE_DEPTH 32 // Frames per class, must be a power of two
+#endif
+// A packet may have up to NUM_MAX_SEGMENTS segments: the sender feeds them in as the ring
+// drains (see scheduler_space()) instead of queueing them all at once.
+
+#if (SCHED_QUEUE_DEPTH & (SCHED_QUEUE_DEPTH - 1)) != 0 || SCHED_QUEUE_DEPTH > 0x8000
+#error "SCHED_QUEUE_DEPTH must be a power of two no larger than 32768"
+#endif
+
+typedef enum {
+    SCHED_CLASS_COMMAND,    // PDU_COMMAND frames
+    SCHED_CLASS_EXPEDITED,  // Data frames with EXPEDITED QoS
+    SCHED_CLASS_SEQUENCED,  // Data frames with SEQUENCED_CONTROLLEED QoS
+    SCHED_NUM_CLASSES
+} SchedClass;
+
+typedef struct {
+    SDUFrame frame;
+    uint32_t enqueued_ms;   // Time of arrival, for the wait-time stats
+} SchedEntry;
+
+typedef struct {
+    uint32_t depth;         // Frames waiting now
+    uint32_t high_water;    // Maximum depth seen
+    uint32_t enqueued;      // Frames accepted
+    uint32_t dropped;       // Frames rejected because the ring was full
+    uint32_t dequeued;      // Frames handed to the radio
+    uint32_t max_wait_ms;   // Longest time a frame waited in the ring
+    uint64_t total_wait_ms; // Sum of the waits, divide by `dequeued` for the mean
+} SchedQueueStats;
+
+typedef struct {
+    SchedEntry entries[SCHED_QUEUE_DEPTH];
+    uint16_t head;          // Next entry to dequeue
+    uint16_t tail;          // Next free entry (head == tail: empty)
+    SchedQueueStats stats;
+} SchedQueue;
+
+typedef struct {
+    SchedQueue queues[SCHED_NUM_CLASSES];
+} FrameScheduler;
+
+void scheduler_init(FrameScheduler* scheduler);
+SchedClass scheduler_class_of(const SDUFrame* frame);
+// O(1). Returns false if the ring of the frame's class is full.
+bool scheduler_enqueue(FrameScheduler* scheduler, const SDUFrame* frame, uint32_t now_ms);
+// O(1). Copies the highest-priority waiting frame to `out`; false if every ring is empty.
+bool scheduler_dequeue(FrameScheduler* scheduler, SDUFrame* out, uint32_t now_ms);
+// Same, keeping the frame's enqueue time (for the enqueue-to-TX_DONE latency metric)
+bool scheduler_dequeue_entry(FrameScheduler* scheduler, SchedEntry* out, uint32_t now_ms);
+// Dequeue the next frame and serialize it into `buffer`. Returns the length, 0 if nothing was sent.
+size_t scheduler_send_into(FrameScheduler* scheduler, uint8_t* buffer, size_t buffer_size, uint32_t now_ms);
+size_t scheduler_depth(const FrameScheduler* scheduler);
+// Free entries in the ring of `sched_class`: enqueue up to this many without a drop
+size_t scheduler_space(const FrameScheduler* scheduler, SchedClass sched_class);
+SchedQueueStats scheduler_get_stats(const FrameScheduler* scheduler, SchedClass sched_class);
+
+// The SDU of the returned frame is an SDU pool block, release it with sdu_pool_free()
 SDUFrame deserialize_sdu_frame(const uint8_t* data);
+// check_sdu_frame() and parse_sdu_frame() count rejected frames in pae_metrics
 bool check_sdu_frame(const SDUFrame* frame);
+// Parse a received frame in place. On success `out` is a view: its SDU points into `data`,
+// so it must not be freed and is only valid while `data` is. Rejects frames whose header,
+// version or data length do not fit in `size` bytes, or whose check sequence is wrong.
+bool parse_sdu_frame(uint8_t* data, size_t size, SDUFrame* out);
 
 #endif // FRAME_SUBLAYER_H
\ No newline at end of file
@@ -0,0 +1,41 @@
+#include "gf256.h"
+
+#include <stdbool.h>
+
+uint8_t gf256_exp[512];
+uint8_t gf256_log[256];
+static bool gf256_ready = false;
+
+void gf256_init(void) {
+    if (gf256_ready) {
+        return;
+    }
+    uint16_t x = 1;
+    for (int i = 0; i < 255; i++) {
+        gf256_exp[i] = (uint8_t)x;
+        gf256_log[x] = (uint8_t)i;
+        x <<= 1;
+        if (x & 0x100) {
+            x ^= GF256_POLY;
+        }
+    }
+    for (int i = 255; i < 512; i++) {
+        gf256_exp[i] = gf256_exp[i - 255];
+    }
+    gf256_log[0] = 0;
+    gf256_ready = true;
+}
+
+void gf256_mul_add(uint8_t *dst, const uint8_t *src, uint8_t c, size_t len) {
+    if (c == 0) {
+        return;
+    }
+    // One table lookup per byte: log(c) is added to the log of each source byte
+    const uint8_t *exp_c = gf256_exp + gf256_log[c];
+    for (size_t i = 0; i < len; i++) {
+        uint8_t s = src[i];
+        if (s != 0) {
+            dst[i] ^= exp_c[gf256_log[s]];
+        }
+    }
+}
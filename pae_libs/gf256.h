@@ -0,0 +1,47 @@
+#ifndef GF256_H
+#define GF256_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// GF(2^8) arithmetic with log/antilog tables.
+// The default field polynomial is the CCSDS one, x^8 + x^7 + x^2 + x + 1 (conventional basis).
+#ifndef GF256_POLY
+#define GF256_POLY 0x187
+#endif
+
+extern uint8_t gf256_exp[512]; // gf256_exp[i] = alpha^i, doubled so that log sums need no modulo
+extern uint8_t gf256_log[256]; // gf256_log[alpha^i] = i, gf256_log[0] is unused
+
+// Build the tables. Called by the users of the field before the first operation.
+void gf256_init(void);
+
+static inline uint8_t gf256_mul(uint8_t a, uint8_t b) {
+    if (a == 0 || b == 0) {
+        return 0;
+    }
+    return gf256_exp[gf256_log[a] + gf256_log[b]];
+}
+
+// b must not be zero
+static inline uint8_t gf256_div(uint8_t a, uint8_t b) {
+    if (a == 0) {
+        return 0;
+    }
+    return gf256_exp[gf256_log[a] + 255 - gf256_log[b]];
+}
+
+// alpha^power for any non-negative power
+static inline uint8_t gf256_alpha_pow(uint32_t power) {
+    return gf256_exp[power % 255];
+}
+
+// a must not be zero
+static inline uint8_t gf256_inv(uint8_t a) {
+    return gf256_exp[255 - gf256_log[a]];
+}
+
+// dst[i] ^= c * src[i] for `len` bytes: the inner loop of the erasure code
+void gf256_mul_add(uint8_t *dst, const uint8_t *src, uint8_t c, size_t len);
+
+#endif // GF256_H
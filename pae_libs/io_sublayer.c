@@ -1,8 +1,17 @@
 #include "io_sublayer.h"
 #include "protocol_definitions.h"
+#include "sdu_pool.h"
+#include "gf256.h"
+#include "pae_metrics.h"
+#include "pae_profile.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
+
+#if SDU_POOL_BLOCKS < IO_BUFFER_MAX_FRAMES
+#error "SDU_POOL_BLOCKS must hold IO_BUFFER_MAX_FRAMES blocks: segment_sdu() copies every segment into the pool"
+#endif
 
 // Define the maximum fragmented SDU size
 #define NUM_MAX_FRAGMENTS_SDU 1024
@@ -49,14 +58,34 @@ void create_buffer(IOBuffer *buffer) {
     memset(buffer, 0, sizeof(IOBuffer)); // Initialize entire buffer to zero
     buffer->size = 0;
     buffer->completframes = 0;
+    buffer->tail = 0;
+    buffer->first_packet = IO_INDEX_NONE;
+    buffer->last_packet = IO_INDEX_NONE;
+}
+
+size_t io_buffer_footprint(void) {
+    return sizeof(IOBuffer);
+}
+
+bool packet_id_is_used(const IOBuffer *buffer, uint32_t packet_id) {
+    if (packet_id >= IO_BUFFER_MAX_PACKETS) {
+        return false;
+    }
+    return (buffer->packet_id_in_use[packet_id / 32] >> (packet_id % 32)) & 1u;
 }
-// Create a new packet_id, used for tracking across all sublayers
+// Create a new packet_id, used for tracking across all sublayers.
+// Lowest free ID first: count trailing zeros of each inverted bitmap word
+// (at most IO_BUFFER_BITMAP_WORDS words, 8 with the default capacity).
 uint32_t generate_packet_id(IOBuffer *buffer) {
-    // Find an available packet_id in the buffer
-    for (uint32_t id = 0; id < NUM_MAX_SEGMENTS; id++) {
-        if (!buffer->packet_id_in_use[id]) {
-            buffer->packet_id_in_use[id] = true; // Mark ID as in use
-            return id;
+    for (uint32_t w = 0; w < IO_BUFFER_BITMAP_WORDS; w++) {
+        uint32_t free_bits = ~buffer->packet_id_in_use[w];
+        if (w == IO_BUFFER_BITMAP_WORDS - 1 && (IO_BUFFER_MAX_PACKETS % 32) != 0) {
+            free_bits &= (1u << (IO_BUFFER_MAX_PACKETS % 32)) - 1u; // Ignore bits past the last ID
+        }
+        if (free_bits != 0) {
+            uint32_t bit = (uint32_t)__builtin_ctz(free_bits);
+            buffer->packet_id_in_use[w] |= 1u << bit; // Mark ID as in use
+            return w * 32 + bit;
         }
     }
     fprintf(stderr, "Error: No available packet_id.\n");
@@ -65,148 +94,666 @@ uint32_t generate_packet_id(IOBuffer *buffer) {
 
 // Release a packet_id
 void release_packet_id(IOBuffer *buffer, uint32_t packet_id) {
-    if (packet_id < NUM_MAX_SEGMENTS) {
-        buffer->packet_id_in_use[packet_id] = false; // Mark ID as not in use
+    if (packet_id < IO_BUFFER_MAX_PACKETS) {
+        buffer->packet_id_in_use[packet_id / 32] &= ~(1u << (packet_id % 32)); // Mark ID as not in use
     } else {
         fprintf(stderr, "Error: Invalid packet_id.\n");
     }
 }
 
-// Segment into multiple segments
-IOBuffer segment_sdu(uint8_t *OBC_data, size_t OBC_data_size, uint8_t PortID, uint8_t PDU_ID, uint16_t SC_ID, uint8_t SD_ID, IOBuffer *buffer) {
-    size_t num_segments = OBC_data_size / MAX_FRAGMENTED_SDU_SIZE;
-    if (OBC_data_size % MAX_FRAGMENTED_SDU_SIZE != 0) {
+// Reserve `count` contiguous frame slots in the ring and append `packet_id` to the
+// packet FIFO. Returns the first slot, or SIZE_MAX if there is no room.
+static size_t reserve_frames(IOBuffer *buffer, uint32_t packet_id, size_t count) {
+    if (count == 0 || count > IO_BUFFER_MAX_FRAMES) {
+        return SIZE_MAX;
+    }
+
+    size_t start;
+    if (buffer->first_packet == IO_INDEX_NONE) {
+        start = 0; // Empty buffer: restart from the beginning
+    } else {
+        size_t head = buffer->index[buffer->first_packet].buffer_position;
+        if (buffer->tail > head) {
+            // Used slots are [head, tail): append at the end or wrap to the front
+            if ((size_t)(IO_BUFFER_MAX_FRAMES - buffer->tail) >= count) {
+                start = buffer->tail;
+            } else if (head >= count) {
+                start = 0;
+            } else {
+                return SIZE_MAX;
+            }
+        } else {
+            // Wrapped: the free slots are [tail, head)
+            if (head - buffer->tail >= count) {
+                start = buffer->tail;
+            } else {
+                return SIZE_MAX;
+            }
+        }
+    }
+    buffer->tail = (io_index_t)(start + count);
+
+    BufferIndexEntry *entry = &buffer->index[packet_id];
+    entry->buffer_position = (io_index_t)start;
+    entry->final_position = (io_index_t)(start + count - 1);
+    entry->prev_packet = buffer->last_packet;
+    entry->next_packet = IO_INDEX_NONE;
+    if (buffer->last_packet == IO_INDEX_NONE) {
+        buffer->first_packet = (io_index_t)packet_id;
+    } else {
+        buffer->index[buffer->last_packet].next_packet = (io_index_t)packet_id;
+    }
+    buffer->last_packet = (io_index_t)packet_id;
+    buffer->size += count;
+    return start;
+}
+
+// Free the SDUs of a packet and unlink it from the FIFO in constant time
+static void drop_packet(IOBuffer *buffer, uint32_t packet_id) {
+    BufferIndexEntry *entry = &buffer->index[packet_id];
+    size_t start = entry->buffer_position;
+    size_t end = entry->final_position;
+
+    // Free the frames associated with the packet_id (pinned SDUs belong to the caller)
+    for (size_t i = start; i <= end; i++) {
+        if (entry->pinned) {
+            // Nothing to free
+        } else if (buffer->frames[i].type == FRAME_UNFRAGMENTED) {
+            sdu_pool_free(buffer->frames[i].data.unfragmented.sdu); // Free memory of unfragmented SDU
+        } else if (buffer->frames[i].type == FRAME_FRAGMENTED) {
+            sdu_pool_free(buffer->frames[i].data.fragmented.sdu); // Free memory of fragmented SDU
+        }
+        memset(&buffer->frames[i], 0, sizeof(SDUFrame)); // Clear the frame
+    }
+    buffer->size -= end - start + 1;
+
+    // Unlink from the arrival order list
+    if (entry->prev_packet == IO_INDEX_NONE) {
+        buffer->first_packet = entry->next_packet;
+    } else {
+        buffer->index[entry->prev_packet].next_packet = entry->next_packet;
+    }
+    if (entry->next_packet == IO_INDEX_NONE) {
+        buffer->last_packet = entry->prev_packet;
+    } else {
+        buffer->index[entry->next_packet].prev_packet = entry->prev_packet;
+    }
+    if (buffer->first_packet == IO_INDEX_NONE) {
+        buffer->tail = 0;
+    }
+
+    release_packet_id(buffer, packet_id); // Mark ID as not in use
+    entry->buffer_position = 0; // Reset the packet's buffer position
+    entry->final_position = 0; // Reset the packet's final buffer position
+    entry->in_nextsublayer = false; // Reset the packet's next sublayer index
+    entry->pinned = false; // Reset the packet's ownership mode
+    entry->prev_packet = IO_INDEX_NONE;
+    entry->next_packet = IO_INDEX_NONE;
+}
+
+// Number of segments needed for a packet of `size` bytes
+static size_t count_segments(size_t size) {
+    size_t num_segments = size / MAX_FRAGMENTED_SDU_SIZE;
+    if (size % MAX_FRAGMENTED_SDU_SIZE != 0) {
         num_segments++;
     }
+    return num_segments;
+}
 
-    if (num_segments > NUM_MAX_SEGMENTS) {
-        fprintf(stderr, "Error: OBC data size exceeds maximum fragmented numbers.\n");
-        return *buffer;
+// Length of segment `i` of a packet of `size` bytes
+static size_t segment_length(size_t size, size_t num_segments, size_t i) {
+    size_t segment_size = MAX_FRAGMENTED_SDU_SIZE;
+    if (i == num_segments - 1) {
+        size_t rem = size % MAX_FRAGMENTED_SDU_SIZE;
+        if (rem != 0) segment_size = rem;
     }
+    return segment_size;
+}
 
-    // Generate unique pseudo packet ID using counter (wraps at 64 since it's 6 bits)
+// Generate unique pseudo packet ID using counter (wraps at 64 since it's 6 bits)
+static uint8_t next_pseudo_packet_id(void) {
     uint8_t pseudo_packet_id = pseudo_packet_counter;
     pseudo_packet_counter = (pseudo_packet_counter + 1) & 0x3F; // Increment and wrap at 64
+    return pseudo_packet_id;
+}
+
+// Headers of segment `i` of `num_segments` (the SDU pointer is left to the caller)
+static SDUFrame create_segment_frame(size_t i, size_t num_segments, size_t segment_size, uint8_t pseudo_packet_id,
+    uint8_t PortID, uint8_t PDU_ID, uint16_t SC_ID, uint8_t SD_ID) {
+    PDUHeader pdu_header = create_pdu_header(VERSION_3, EXPEDITED, PDU_ID, DFC_FRAGMENTED, SC_ID, PRIMARYCANAL,
+                                             PortID, SD_ID, segment_size, i);
+
+    SegmentationHeader seg_header;
+    if (num_segments == 1) {
+        seg_header = create_segmentation_header(NO_SEGMENT, pseudo_packet_id);
+    } else if (i == 0) {
+        seg_header = create_segmentation_header(FIRST_SEGMENT, pseudo_packet_id);
+    } else if (i == num_segments - 1) {
+        seg_header = create_segmentation_header(LAST_SEGMENT, pseudo_packet_id);
+    } else {
+        seg_header = create_segmentation_header(MIDDLE_SEGMENT, pseudo_packet_id);
+    }
+
+    SDUFrame frame = {0};
+    frame.type = FRAME_FRAGMENTED;
+    frame.data.fragmented.pdu_header = pdu_header;
+    frame.data.fragmented.seg_header = seg_header;
+    return frame;
+}
+
+// Store the segments of OBC_data in the buffer. When `pinned` is set the frames
+// point into OBC_data instead of owning a heap copy of each segment.
+static uint32_t store_segments(uint8_t *OBC_data, size_t OBC_data_size, uint8_t PortID, uint8_t PDU_ID,
+    uint16_t SC_ID, uint8_t SD_ID, IOBuffer *buffer, bool pinned) {
+    size_t num_segments = count_segments(OBC_data_size);
+    if (num_segments > NUM_MAX_SEGMENTS) {
+        fprintf(stderr, "Error: OBC data size exceeds maximum fragmented numbers.\n");
+        return UINT32_MAX;
+    }
+
+    uint8_t pseudo_packet_id = next_pseudo_packet_id();
     
     uint32_t packet_id = generate_packet_id(buffer);
-    buffer->index[packet_id].buffer_position = buffer->size; 
-    buffer->index[packet_id].final_position = buffer->size + num_segments - 1;
+    if (packet_id == UINT32_MAX) {
+        return UINT32_MAX;
+    }
+    size_t start = reserve_frames(buffer, packet_id, num_segments);
+    if (start == SIZE_MAX) {
+        fprintf(stderr, "Error: Not enough free frames in the buffer.\n");
+        release_packet_id(buffer, packet_id);
+        return UINT32_MAX;
+    }
+    buffer->index[packet_id].pinned = pinned;
 
     for (size_t i = 0; i < num_segments; i++) {
-        size_t segment_size = MAX_FRAGMENTED_SDU_SIZE;
-        if (i == num_segments - 1) {
-             size_t rem = OBC_data_size % MAX_FRAGMENTED_SDU_SIZE;
-             if (rem != 0) segment_size = rem;
-        }
-
-        PDUHeader pdu_header = create_pdu_header(VERSION_3, EXPEDITED, PDU_ID, DFC_FRAGMENTED, SC_ID, PRIMARYCANAL,
-                                                 PortID, SD_ID, segment_size, i);
-
-        SegmentationHeader seg_header;
-        if (num_segments == 1) {
-            seg_header = create_segmentation_header(NO_SEGMENT, pseudo_packet_id);
-        } else if (i == 0) {
-            seg_header = create_segmentation_header(FIRST_SEGMENT, pseudo_packet_id);
-        } else if (i == num_segments - 1) {
-            seg_header = create_segmentation_header(LAST_SEGMENT, pseudo_packet_id);
+        size_t segment_size = segment_length(OBC_data_size, num_segments, i);
+        SDUFrame frame = create_segment_frame(i, num_segments, segment_size, pseudo_packet_id,
+                                              PortID, PDU_ID, SC_ID, SD_ID);
+
+        if (pinned) {
+            // Slice of the caller's SDU, no copy
+            frame.data.fragmented.sdu = OBC_data + (i * MAX_FRAGMENTED_SDU_SIZE);
         } else {
-            seg_header = create_segmentation_header(MIDDLE_SEGMENT, pseudo_packet_id);
+            frame.data.fragmented.sdu = sdu_pool_alloc(segment_size);
+            if (frame.data.fragmented.sdu == NULL) {
+                fprintf(stderr, "Error: Memory allocation failed for fragmented SDU.\n");
+                drop_packet(buffer, packet_id); // Release the segments stored so far
+                return UINT32_MAX;
+            }
+            memcpy(frame.data.fragmented.sdu, OBC_data + (i * MAX_FRAGMENTED_SDU_SIZE), segment_size);
         }
 
-        SDUFrame frame = {0};
-        frame.type = FRAME_FRAGMENTED;
-        frame.data.fragmented.pdu_header = pdu_header;
-        frame.data.fragmented.seg_header = seg_header;
+        buffer->frames[start + i] = frame;
+    }
+    buffer->completframes++;
+    return packet_id;
+}
 
-        frame.data.fragmented.sdu = (uint8_t *)malloc(segment_size);
-        if (frame.data.fragmented.sdu == NULL) {
-            fprintf(stderr, "Error: Memory allocation failed for fragmented SDU.\n");
-            return *buffer;
+// Segment into multiple segments
+IOBuffer segment_sdu(uint8_t *OBC_data, size_t OBC_data_size, uint8_t PortID, uint8_t PDU_ID, uint16_t SC_ID, uint8_t SD_ID, IOBuffer *buffer) {
+    PAE_PROFILE_SCOPE(PAE_PROBE_SEGMENT_SDU); // Includes the IOBuffer copy returned
+    PAE_PROFILE_BYTES(OBC_data_size);
+    store_segments(OBC_data, OBC_data_size, PortID, PDU_ID, SC_ID, SD_ID, buffer, false);
+    return *buffer;
+}
+
+// Segment into multiple segments without copying: each frame is a view into OBC_data
+uint32_t segment_sdu_pinned(uint8_t *OBC_data, size_t OBC_data_size, uint8_t PortID, uint8_t PDU_ID, uint16_t SC_ID, uint8_t SD_ID, IOBuffer *buffer) {
+    PAE_PROFILE_SCOPE(PAE_PROBE_SEGMENT_SDU);
+    PAE_PROFILE_BYTES(OBC_data_size);
+    return store_segments(OBC_data, OBC_data_size, PortID, PDU_ID, SC_ID, SD_ID, buffer, true);
+}
+
+// Streaming segmentation: one segment at a time, straight from the source
+
+static bool segment_iterator_setup(SegmentIterator *it, size_t OBC_data_size, uint8_t PortID, uint8_t PDU_ID,
+    uint16_t SC_ID, uint8_t SD_ID) {
+    it->total_size = OBC_data_size;
+    it->num_segments = count_segments(OBC_data_size);
+    it->next_segment = 0;
+    if (it->num_segments == 0 || it->num_segments > NUM_MAX_SEGMENTS) {
+        fprintf(stderr, "Error: OBC data size exceeds maximum fragmented numbers.\n");
+        it->num_segments = 0;
+        return false;
+    }
+    it->pseudo_packet_id = next_pseudo_packet_id();
+    it->port_id = PortID;
+    it->pdu_id = PDU_ID;
+    it->sc_id = SC_ID;
+    it->sd_id = SD_ID;
+    return true;
+}
+
+bool segment_iterator_init(SegmentIterator *it, const uint8_t *OBC_data, size_t OBC_data_size, uint8_t PortID,
+    uint8_t PDU_ID, uint16_t SC_ID, uint8_t SD_ID) {
+    memset(it, 0, offsetof(SegmentIterator, scratch));
+    it->source = OBC_data;
+    return OBC_data != NULL && segment_iterator_setup(it, OBC_data_size, PortID, PDU_ID, SC_ID, SD_ID);
+}
+
+bool segment_iterator_init_pull(SegmentIterator *it, SegmentPullFn pull, void *pull_ctx, size_t OBC_data_size,
+    uint8_t PortID, uint8_t PDU_ID, uint16_t SC_ID, uint8_t SD_ID) {
+    memset(it, 0, offsetof(SegmentIterator, scratch));
+    it->pull = pull;
+    it->pull_ctx = pull_ctx;
+    return pull != NULL && segment_iterator_setup(it, OBC_data_size, PortID, PDU_ID, SC_ID, SD_ID);
+}
+
+bool segment_iterator_next(SegmentIterator *it, SDUFrame *frame) {
+    if (it->next_segment >= it->num_segments) {
+        return false; // All segments produced
+    }
+
+    size_t i = it->next_segment;
+    size_t segment_size = segment_length(it->total_size, it->num_segments, i);
+    size_t offset = i * MAX_FRAGMENTED_SDU_SIZE;
+
+    *frame = create_segment_frame(i, it->num_segments, segment_size, it->pseudo_packet_id,
+                                  it->port_id, it->pdu_id, it->sc_id, it->sd_id);
+    if (it->source != NULL) {
+        frame->data.fragmented.sdu = (uint8_t *)it->source + offset; // View into the source, no copy
+    } else {
+        if (it->pull(it->pull_ctx, offset, it->scratch, segment_size) != segment_size) {
+            fprintf(stderr, "Error: Segment source returned less data than requested.\n");
+            return false;
         }
-        memcpy(frame.data.fragmented.sdu, OBC_data + (i * MAX_FRAGMENTED_SDU_SIZE), segment_size);
+        frame->data.fragmented.sdu = it->scratch;
+    }
+
+    it->next_segment++;
+    return true;
+}
+
+bool segment_iterator_done(const SegmentIterator *it) {
+    return it->next_segment >= it->num_segments;
+}
 
-        buffer->frames[buffer->size] = frame;
-        buffer->size++;
+// Erasure-coded segmentation
+
+static uint8_t erasure_overhead[NUM_PORTS]; // Repair percentage per port, 0 = off
+
+void erasure_set_port_overhead(uint8_t PortID, uint8_t percent) {
+    if (PortID < NUM_PORTS) {
+        erasure_overhead[PortID] = percent;
     }
-    buffer->completframes++;
-    return *buffer;
 }
 
-// Function to create an unfragmented SDU
-SDUFrame create_unfragmented_sdu(uint8_t *OBC_data, size_t OBC_data_size, uint8_t PortID, uint8_t PDU_ID, uint16_t SC_ID, uint8_t SD_ID, IOBuffer *buffer) {
+uint8_t erasure_port_overhead(uint8_t PortID) {
+    return (PortID < NUM_PORTS) ? erasure_overhead[PortID] : 0;
+}
+
+// Cauchy matrix entry for repair segment `p` and data segment `i`: 1 / (x_p + y_i) with
+// x_p = k + p and y_i = i, all distinct, so every square submatrix is invertible
+static uint8_t erasure_coefficient(size_t k, size_t p, size_t i) {
+    return gf256_inv((uint8_t)((k + p) ^ i));
+}
+
+// Bytes carried by segment `index` of a packet of `total_size` bytes in `k` data segments
+static size_t erasure_segment_length(size_t total_size, size_t k, size_t index) {
+    if (index < k - 1) {
+        return ERASURE_SEGMENT_SIZE;
+    }
+    if (index == k - 1) {
+        return total_size - (k - 1) * ERASURE_SEGMENT_SIZE; // Last data segment
+    }
+    return (k == 1) ? total_size : ERASURE_SEGMENT_SIZE; // Repair segment
+}
+
+bool erasure_iterator_init(ErasureIterator *it, const uint8_t *OBC_data, size_t OBC_data_size, uint8_t PortID,
+    uint8_t PDU_ID, uint16_t SC_ID, uint8_t SD_ID) {
+    memset(it, 0, offsetof(ErasureIterator, scratch));
+    uint8_t overhead = erasure_port_overhead(PortID);
+    if (OBC_data == NULL || OBC_data_size == 0 || overhead == 0) {
+        fprintf(stderr, "Error: Erasure coding is not enabled for this port.\n");
+        return false;
+    }
+    if (OBC_data_size > ERASURE_MAX_PACKET_SIZE) {
+        fprintf(stderr, "Error: OBC data size exceeds what the erasure decoder can rebuild.\n");
+        return false;
+    }
+
+    size_t k = (OBC_data_size + ERASURE_SEGMENT_SIZE - 1) / ERASURE_SEGMENT_SIZE;
+    size_t m = (k * overhead + 99) / 100; // Round up: at least one repair segment
+    if (k + m > ERASURE_MAX_TOTAL_SEGMENTS) {
+        fprintf(stderr, "Error: OBC data size exceeds maximum erasure-coded size.\n");
+        return false;
+    }
+
+    gf256_init();
+    it->source = OBC_data;
+    it->total_size = OBC_data_size;
+    it->k = (uint8_t)k;
+    it->n = (uint8_t)(k + m);
+    it->pseudo_packet_id = next_pseudo_packet_id();
+    it->port_id = PortID;
+    it->pdu_id = PDU_ID;
+    it->sc_id = SC_ID;
+    it->sd_id = SD_ID;
+    return true;
+}
+
+bool erasure_iterator_next(ErasureIterator *it, SDUFrame *frame) {
+    if (it->next_segment >= it->n) {
+        return false; // All segments produced
+    }
+
+    size_t index = it->next_segment;
+    size_t length = erasure_segment_length(it->total_size, it->k, index);
+    uint8_t *payload = it->scratch + SIZE_ERASURE_HEADER;
+    it->scratch[0] = (uint8_t)index;
+    it->scratch[1] = it->k;
+    it->scratch[2] = (uint8_t)(it->total_size >> 8);
+    it->scratch[3] = (uint8_t)it->total_size;
+
+    if (index < it->k) {
+        memcpy(payload, it->source + index * ERASURE_SEGMENT_SIZE, length);
+    } else {
+        // Repair segment: sum over the data segments, each scaled by its Cauchy coefficient
+        memset(payload, 0, length);
+        for (size_t i = 0; i < it->k; i++) {
+            gf256_mul_add(payload, it->source + i * ERASURE_SEGMENT_SIZE,
+                erasure_coefficient(it->k, index - it->k, i), erasure_segment_length(it->total_size, it->k, i));
+        }
+    }
+
+    *frame = create_segment_frame(index, it->n, SIZE_ERASURE_HEADER + length, it->pseudo_packet_id,
+                                  it->port_id, it->pdu_id, it->sc_id, it->sd_id);
+    frame->data.fragmented.sdu = it->scratch;
+    it->next_segment++;
+    return true;
+}
+
+void erasure_decoder_init(ErasureDecoder *decoder) {
+    memset(decoder, 0, sizeof(ErasureDecoder));
+    gf256_init();
+}
+
+// Invert the e x e matrix in place (Gauss-Jordan). False if it is singular.
+static bool erasure_invert(uint8_t matrix[][ERASURE_MAX_DATA_SEGMENTS], size_t e) {
+    static uint8_t inverse[ERASURE_MAX_DATA_SEGMENTS][ERASURE_MAX_DATA_SEGMENTS];
+    for (size_t r = 0; r < e; r++) {
+        memset(inverse[r], 0, e);
+        inverse[r][r] = 1;
+    }
+    for (size_t col = 0; col < e; col++) {
+        size_t pivot = col;
+        while (pivot < e && matrix[pivot][col] == 0) {
+            pivot++;
+        }
+        if (pivot == e) {
+            return false;
+        }
+        if (pivot != col) {
+            for (size_t j = 0; j < e; j++) {
+                uint8_t t = matrix[col][j]; matrix[col][j] = matrix[pivot][j]; matrix[pivot][j] = t;
+                t = inverse[col][j]; inverse[col][j] = inverse[pivot][j]; inverse[pivot][j] = t;
+            }
+        }
+        uint8_t scale = gf256_inv(matrix[col][col]);
+        for (size_t j = 0; j < e; j++) {
+            matrix[col][j] = gf256_mul(matrix[col][j], scale);
+            inverse[col][j] = gf256_mul(inverse[col][j], scale);
+        }
+        for (size_t r = 0; r < e; r++) {
+            uint8_t factor = matrix[r][col];
+            if (r != col && factor != 0) {
+                gf256_mul_add(matrix[r], matrix[col], factor, e);
+                gf256_mul_add(inverse[r], inverse[col], factor, e);
+            }
+        }
+    }
+    for (size_t r = 0; r < e; r++) {
+        memcpy(matrix[r], inverse[r], e);
+    }
+    return true;
+}
+
+// Rebuild the data segments whose slots hold repair segments
+static bool erasure_decode(ErasureDecoder *decoder) {
+    static uint8_t matrix[ERASURE_MAX_DATA_SEGMENTS][ERASURE_MAX_DATA_SEGMENTS];
+    uint8_t missing[ERASURE_MAX_DATA_SEGMENTS]; // Slots (= missing data indices) holding repairs
+    size_t k = decoder->k;
+    size_t e = 0;
+    for (size_t s = 0; s < k; s++) {
+        if (decoder->slot_segment[s] != s) {
+            missing[e++] = (uint8_t)s;
+        }
+    }
+    if (e == 0) {
+        return true; // Every data segment arrived
+    }
+
+    // Remove the known data from each repair segment, leaving only the missing unknowns
+    for (size_t a = 0; a < e; a++) {
+        uint8_t *repair = decoder->data + missing[a] * ERASURE_SEGMENT_SIZE;
+        size_t p = decoder->slot_segment[missing[a]] - k;
+        for (size_t i = 0; i < k; i++) {
+            if (decoder->slot_segment[i] == i) {
+                gf256_mul_add(repair, decoder->data + i * ERASURE_SEGMENT_SIZE, erasure_coefficient(k, p, i),
+                    ERASURE_SEGMENT_SIZE);
+            }
+        }
+        for (size_t b = 0; b < e; b++) {
+            matrix[a][b] = erasure_coefficient(k, p, missing[b]);
+        }
+    }
+    if (!erasure_invert(matrix, e)) {
+        return false;
+    }
+
+    // Solve byte by byte: missing[b] = sum over a of inverse[b][a] * repair[a]
+    uint8_t column[ERASURE_MAX_DATA_SEGMENTS];
+    for (size_t j = 0; j < ERASURE_SEGMENT_SIZE; j++) {
+        for (size_t a = 0; a < e; a++) {
+            column[a] = decoder->data[missing[a] * ERASURE_SEGMENT_SIZE + j];
+        }
+        for (size_t b = 0; b < e; b++) {
+            uint8_t value = 0;
+            for (size_t a = 0; a < e; a++) {
+                value ^= gf256_mul(matrix[b][a], column[a]);
+            }
+            decoder->data[missing[b] * ERASURE_SEGMENT_SIZE + j] = value;
+        }
+    }
+    for (size_t b = 0; b < e; b++) {
+        decoder->slot_segment[missing[b]] = missing[b];
+    }
+    decoder->recovered += e;
+    return true;
+}
+
+ReassemblyStatus erasure_push(ErasureDecoder *decoder, const SDUFrame *frame, uint32_t now_ms, SerializedData *out) {
+    if (frame == NULL || out == NULL || frame->type != FRAME_FRAGMENTED || frame->data.fragmented.sdu == NULL) {
+        return REASSEMBLY_ERROR;
+    }
+
+    const PDUHeader *hdr = &frame->data.fragmented.pdu_header;
+    const uint8_t *sdu = frame->data.fragmented.sdu;
+    size_t seg_len = ((size_t)hdr->data_length_high << 8) | hdr->data_length_low;
+    if (seg_len <= SIZE_ERASURE_HEADER) {
+        return REASSEMBLY_ERROR;
+    }
+    size_t index = sdu[0];
+    size_t k = sdu[1];
+    size_t length = ((size_t)sdu[2] << 8) | sdu[3];
+    if (k == 0 || k > ERASURE_MAX_DATA_SEGMENTS || length > ERASURE_MAX_PACKET_SIZE ||
+        (length + ERASURE_SEGMENT_SIZE - 1) / ERASURE_SEGMENT_SIZE != k ||
+        seg_len - SIZE_ERASURE_HEADER != erasure_segment_length(length, k, index)) {
+        return REASSEMBLY_ERROR; // Inconsistent erasure header
+    }
+
+    uint16_t sc_id = ((uint16_t)hdr->SC_ID_part1 << 8) | hdr->SC_ID_part2;
+    uint8_t pseudo_packet_id = frame->data.fragmented.seg_header.PseudoPacketID;
+    if (!decoder->in_use || decoder->sc_id != sc_id || decoder->pseudo_packet_id != pseudo_packet_id) {
+        // A new packet replaces the one being rebuilt
+        decoder->in_use = true;
+        decoder->complete = false;
+        decoder->sc_id = sc_id;
+        decoder->pseudo_packet_id = pseudo_packet_id;
+        decoder->k = (uint8_t)k;
+        decoder->length = (uint16_t)length;
+        decoder->received = 0;
+        memset(decoder->slot_segment, 0xFF, sizeof(decoder->slot_segment));
+        memset(decoder->data, 0, k * ERASURE_SEGMENT_SIZE);
+    } else if (decoder->k != k || decoder->length != length) {
+        return REASSEMBLY_ERROR;
+    }
+    decoder->last_activity_ms = now_ms;
+    if (decoder->complete) {
+        return REASSEMBLY_DUPLICATE; // Surplus segment of a packet already rebuilt
+    }
+
+    // Choose the slot: its own for a data segment, any free one for a repair segment
+    size_t slot = SIZE_MAX;
+    size_t free_slot = SIZE_MAX;
+    for (size_t s = 0; s < k; s++) {
+        if (decoder->slot_segment[s] == index) {
+            return REASSEMBLY_DUPLICATE;
+        }
+        if (decoder->slot_segment[s] == 0xFF && s != index) {
+            free_slot = s;
+        }
+    }
+    if (index < k) {
+        slot = index;
+        if (decoder->slot_segment[slot] != 0xFF) {
+            // A repair segment is parked here: move it to another free slot
+            memcpy(decoder->data + free_slot * ERASURE_SEGMENT_SIZE, decoder->data + slot * ERASURE_SEGMENT_SIZE,
+                ERASURE_SEGMENT_SIZE);
+            decoder->slot_segment[free_slot] = decoder->slot_segment[slot];
+        }
+    } else {
+        slot = free_slot; // One is always free while fewer than k segments are held
+    }
+
+    uint8_t *dst = decoder->data + slot * ERASURE_SEGMENT_SIZE;
+    memset(dst, 0, ERASURE_SEGMENT_SIZE);
+    memcpy(dst, sdu + SIZE_ERASURE_HEADER, seg_len - SIZE_ERASURE_HEADER);
+    decoder->slot_segment[slot] = (uint8_t)index;
+    decoder->received++;
+
+    if (decoder->received < k) {
+        return REASSEMBLY_IN_PROGRESS;
+    }
+    if (!erasure_decode(decoder)) {
+        decoder->in_use = false;
+        return REASSEMBLY_ERROR;
+    }
+    decoder->complete = true;
+    decoder->decoded++;
+    pae_metrics_reassembly_completed();
+    out->data = decoder->data;
+    out->length = decoder->length;
+    return REASSEMBLY_COMPLETE;
+}
+
+size_t erasure_expire(ErasureDecoder *decoder, uint32_t now_ms) {
+    if (!decoder->in_use || (uint32_t)(now_ms - decoder->last_activity_ms) < REASSEMBLY_TIMEOUT_MS) {
+        return 0;
+    }
+    // A delivered packet is only kept to ignore its surplus segments: forget it quietly
+    decoder->in_use = false;
+    if (decoder->complete) {
+        return 0;
+    }
+    decoder->timeouts++;
+    pae_metrics_reassembly_timeouts(1);
+    return 1;
+}
+
+// Copy an unfragmented SDU into a pool block and store it in the buffer
+static uint32_t store_unfragmented(uint8_t *OBC_data, size_t OBC_data_size, uint8_t DFC_ID, uint8_t PortID,
+    uint8_t PDU_ID, uint16_t SC_ID, uint8_t SD_ID, IOBuffer *buffer, SDUFrame *out_frame) {
     SDUFrame frame = {0}; // Initialize frame to zero
+    *out_frame = frame;
 
     // Check if OBC_data is too large to be unfragmented
     if (OBC_data_size > MAX_UNFRAGMENTED_SDU_SIZE) {
         fprintf(stderr, "Error: OBC data size exceeds maximum unfragmented size.\n");
-        return frame; // Return an empty frame in case of error
+        return UINT32_MAX;
     }
 
     frame.type = FRAME_UNFRAGMENTED; // Indicate that it is an unfragmented frame
 
     // Create the PDU header
-    PDUHeader pdu_header = create_pdu_header(VERSION_3, EXPEDITED, PDU_ID, DFC_PACKETS, SC_ID, PRIMARYCANAL,
+    PDUHeader pdu_header = create_pdu_header(VERSION_3, EXPEDITED, PDU_ID, DFC_ID, SC_ID, PRIMARYCANAL,
         PortID, SD_ID, OBC_data_size, 0);
     frame.data.unfragmented.header = pdu_header;
 
-    // Allocate dynamic memory for the SDU and copy the data
-    frame.data.unfragmented.sdu = (uint8_t *)malloc(OBC_data_size);
+    // Take a block from the SDU pool and copy the data
+    frame.data.unfragmented.sdu = sdu_pool_alloc(OBC_data_size);
     if (frame.data.unfragmented.sdu == NULL) {
         fprintf(stderr, "Error: Memory allocation failed for unfragmented SDU.\n");
-        return frame;
+        *out_frame = frame;
+        return UINT32_MAX;
     }
     memcpy(frame.data.unfragmented.sdu, OBC_data, OBC_data_size);
 
     // Save the frame in the buffer
     uint32_t packet_id = generate_packet_id(buffer);
-    buffer->index[packet_id].buffer_position = buffer->size;
-    buffer->index[packet_id].final_position = buffer->size;
-    buffer->frames[buffer->size] = frame;
-    buffer->size++;
+    size_t start = (packet_id == UINT32_MAX) ? SIZE_MAX : reserve_frames(buffer, packet_id, 1);
+    if (start == SIZE_MAX) {
+        fprintf(stderr, "Error: Not enough free frames in the buffer.\n");
+        if (packet_id != UINT32_MAX) {
+            release_packet_id(buffer, packet_id);
+        }
+        sdu_pool_free(frame.data.unfragmented.sdu);
+        frame.data.unfragmented.sdu = NULL;
+        *out_frame = frame;
+        return UINT32_MAX;
+    }
+    buffer->frames[start] = frame;
     buffer->completframes++;
 
+    *out_frame = frame;
+    return packet_id;
+}
+
+// Function to create an unfragmented SDU
+SDUFrame create_unfragmented_sdu(uint8_t *OBC_data, size_t OBC_data_size, uint8_t PortID, uint8_t PDU_ID, uint16_t SC_ID, uint8_t SD_ID, IOBuffer *buffer) {
+    SDUFrame frame;
+    store_unfragmented(OBC_data, OBC_data_size, DFC_PACKETS, PortID, PDU_ID, SC_ID, SD_ID, buffer, &frame);
     return frame;
 }
 
-// Function to free the frame buffer
-void free_buffer(IOBuffer *buffer, uint32_t packet_id) {
-    if (packet_id < NUM_MAX_SEGMENTS) {
-        size_t start = buffer->index[packet_id].buffer_position;
-        size_t end = buffer->index[packet_id].final_position;
-        size_t num_frames_to_remove = end - start + 1;
-
-        // Free the frames associated with the packet_id
-        for (size_t i = start; i <= end; i++) {
-            if (buffer->frames[i].type == FRAME_UNFRAGMENTED) {
-                free(buffer->frames[i].data.unfragmented.sdu); // Free memory of unfragmented SDU
-            } else if (buffer->frames[i].type == FRAME_FRAGMENTED) {
-                free(buffer->frames[i].data.fragmented.sdu); // Free memory of fragmented SDU
-            }
-            memset(&buffer->frames[i], 0, sizeof(SDUFrame)); // Clear the frame
-        }
+// Create an unfragmented SDU without copying: the frame is a view into OBC_data
+uint32_t create_unfragmented_sdu_pinned(uint8_t *OBC_data, size_t OBC_data_size, uint8_t PortID, uint8_t PDU_ID, uint16_t SC_ID, uint8_t SD_ID, IOBuffer *buffer) {
+    if (OBC_data_size > MAX_UNFRAGMENTED_SDU_SIZE) {
+        fprintf(stderr, "Error: OBC data size exceeds maximum unfragmented size.\n");
+        return UINT32_MAX;
+    }
 
-        // Move the remaining frames to fill the gap
-        for (size_t i = end + 1; i < buffer->size; i++) {
-            buffer->frames[i - num_frames_to_remove] = buffer->frames[i];
-        }
+    uint32_t packet_id = generate_packet_id(buffer);
+    if (packet_id == UINT32_MAX) {
+        return UINT32_MAX;
+    }
 
-        // Update buffer size
-        buffer->size -= num_frames_to_remove;
+    SDUFrame frame = {0};
+    frame.type = FRAME_UNFRAGMENTED;
+    frame.data.unfragmented.header = create_pdu_header(VERSION_3, EXPEDITED, PDU_ID, DFC_PACKETS, SC_ID, PRIMARYCANAL,
+        PortID, SD_ID, OBC_data_size, 0);
+    frame.data.unfragmented.sdu = OBC_data;
 
-        // Update the index positions in the buffer
-        for (uint32_t i = 0; i < NUM_MAX_SEGMENTS; i++) {
-            if (buffer->packet_id_in_use[i] && buffer->index[i].buffer_position > end) {
-                buffer->index[i].buffer_position -= num_frames_to_remove;
-                buffer->index[i].final_position -= num_frames_to_remove;
-            }
-        }
-        buffer->packet_id_in_use[packet_id] = false; // Mark ID as not in use
-        buffer->index[packet_id].buffer_position = 0; // Reset the packet's buffer position
-        buffer->index[packet_id].final_position = 0; // Reset the packet's final buffer position
-        buffer->index[packet_id].in_nextsublayer = false; // Reset the packet's next sublayer index
-    } else {
+    size_t start = reserve_frames(buffer, packet_id, 1);
+    if (start == SIZE_MAX) {
+        fprintf(stderr, "Error: Not enough free frames in the buffer.\n");
+        release_packet_id(buffer, packet_id);
+        return UINT32_MAX;
+    }
+    buffer->index[packet_id].pinned = true;
+    buffer->frames[start] = frame;
+    buffer->completframes++;
+
+    return packet_id;
+}
+
+// Function to free the frame buffer (O(1) apart from releasing the packet's own SDUs)
+void free_buffer(IOBuffer *buffer, uint32_t packet_id) {
+    if (!packet_id_is_used(buffer, packet_id)) {
         fprintf(stderr, "Error: Invalid packet_id.\n");
+        return;
     }
+    drop_packet(buffer, packet_id);
     buffer->completframes--; // Decrement the number of complete frames in the buffer
 }
 
@@ -219,7 +766,7 @@ SDUFrame* send_to_next_sublayer(IOBuffer *buffer, uint32_t packet_id, size_t *fr
     *frames_count = 0;
 
     SDUFrame* frames_to_send = NULL; // Initialize pointer to frames to send
-    if (packet_id >= NUM_MAX_SEGMENTS) {
+    if (packet_id >= IO_BUFFER_MAX_PACKETS) {
         fprintf(stderr, "Error: Invalid packet_id.\n");
         return NULL;
     }
@@ -252,13 +799,13 @@ SDUFrame* send_to_next_sublayer(IOBuffer *buffer, uint32_t packet_id, size_t *fr
             frames_to_send[idx].data.unfragmented.header = src->data.unfragmented.header;
             size_t len = src->data.unfragmented.header.data_length_low;
             if (len > 0) {
-                frames_to_send[idx].data.unfragmented.sdu = (uint8_t*)malloc(len);
+                frames_to_send[idx].data.unfragmented.sdu = sdu_pool_alloc(len);
                 if (frames_to_send[idx].data.unfragmented.sdu == NULL) {
                     fprintf(stderr, "Error: Memory allocation failed for unfragmented SDU.\n");
                     // cleanup
                     for (size_t j = 0; j < idx; ++j) {
-                        if (frames_to_send[j].type == FRAME_UNFRAGMENTED && frames_to_send[j].data.unfragmented.sdu) free(frames_to_send[j].data.unfragmented.sdu);
-                        if (frames_to_send[j].type == FRAME_FRAGMENTED && frames_to_send[j].data.fragmented.sdu) free(frames_to_send[j].data.fragmented.sdu);
+                        if (frames_to_send[j].type == FRAME_UNFRAGMENTED && frames_to_send[j].data.unfragmented.sdu) sdu_pool_free(frames_to_send[j].data.unfragmented.sdu);
+                        if (frames_to_send[j].type == FRAME_FRAGMENTED && frames_to_send[j].data.fragmented.sdu) sdu_pool_free(frames_to_send[j].data.fragmented.sdu);
                     }
                     free(frames_to_send);
                     return NULL;
@@ -273,13 +820,13 @@ SDUFrame* send_to_next_sublayer(IOBuffer *buffer, uint32_t packet_id, size_t *fr
             frames_to_send[idx].data.fragmented.seg_header = src->data.fragmented.seg_header;
             size_t seg_len = src->data.fragmented.pdu_header.data_length_low;
             if (seg_len > 0) {
-                frames_to_send[idx].data.fragmented.sdu = (uint8_t*)malloc(seg_len);
+                frames_to_send[idx].data.fragmented.sdu = sdu_pool_alloc(seg_len);
                 if (frames_to_send[idx].data.fragmented.sdu == NULL) {
                     fprintf(stderr, "Error: Memory allocation failed for fragmented SDU.\n");
                     // cleanup
                     for (size_t j = 0; j < idx; ++j) {
-                        if (frames_to_send[j].type == FRAME_UNFRAGMENTED && frames_to_send[j].data.unfragmented.sdu) free(frames_to_send[j].data.unfragmented.sdu);
-                        if (frames_to_send[j].type == FRAME_FRAGMENTED && frames_to_send[j].data.fragmented.sdu) free(frames_to_send[j].data.fragmented.sdu);
+                        if (frames_to_send[j].type == FRAME_UNFRAGMENTED && frames_to_send[j].data.unfragmented.sdu) sdu_pool_free(frames_to_send[j].data.unfragmented.sdu);
+                        if (frames_to_send[j].type == FRAME_FRAGMENTED && frames_to_send[j].data.fragmented.sdu) sdu_pool_free(frames_to_send[j].data.fragmented.sdu);
                     }
                     free(frames_to_send);
                     return NULL;
@@ -300,14 +847,201 @@ SDUFrame* send_to_next_sublayer(IOBuffer *buffer, uint32_t packet_id, size_t *fr
     return frames_to_send; // Return the frames to send
 }
 
+// Hand the frames of a packet to the next sublayer without copying the SDUs
+SDUFrame* move_to_next_sublayer(IOBuffer *buffer, uint32_t packet_id, size_t *frames_count) {
+    if (frames_count == NULL) {
+        fprintf(stderr, "Error: frames_count must not be NULL.\n");
+        return NULL;
+    }
+    *frames_count = 0;
+
+    if (!packet_id_is_used(buffer, packet_id)) {
+        fprintf(stderr, "Error: Invalid packet_id.\n");
+        return NULL;
+    }
+    BufferIndexEntry *entry = &buffer->index[packet_id];
+    if (entry->pinned) {
+        // The SDUs belong to the caller, the buffer cannot give them away
+        return send_to_next_sublayer(buffer, packet_id, frames_count);
+    }
+    if (entry->in_nextsublayer) {
+        fprintf(stderr, "Error: Packet already handed to the next sublayer.\n");
+        return NULL;
+    }
+
+    size_t start = entry->buffer_position;
+    size_t num_frames_to_send = (size_t)entry->final_position - start + 1;
+    SDUFrame* frames_to_send = (SDUFrame*)malloc(num_frames_to_send * sizeof(SDUFrame));
+    if (frames_to_send == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed for frames array.\n");
+        return NULL;
+    }
+
+    // Copy the descriptors only and drop the buffer's reference to each SDU
+    memcpy(frames_to_send, &buffer->frames[start], num_frames_to_send * sizeof(SDUFrame));
+    for (size_t i = start; i < start + num_frames_to_send; i++) {
+        if (buffer->frames[i].type == FRAME_UNFRAGMENTED) {
+            buffer->frames[i].data.unfragmented.sdu = NULL;
+        } else {
+            buffer->frames[i].data.fragmented.sdu = NULL;
+        }
+    }
+
+    *frames_count = num_frames_to_send;
+    entry->in_nextsublayer = true; // In flight: the slots stay reserved until free_buffer()
+    return frames_to_send;
+}
+
+// Borrowed view of the frames of a packet (no allocation, no copy)
+const SDUFrame* get_packet_frames(IOBuffer *buffer, uint32_t packet_id, size_t *out_count) {
+    if (out_count == NULL) {
+        fprintf(stderr, "Error: out_count must not be NULL.\n");
+        return NULL;
+    }
+    *out_count = 0;
+
+    if (!packet_id_is_used(buffer, packet_id)) {
+        fprintf(stderr, "Error: Invalid packet_id.\n");
+        return NULL;
+    }
+
+    size_t start = buffer->index[packet_id].buffer_position;
+    size_t end = buffer->index[packet_id].final_position;
+    if (end < start) {
+        return NULL;
+    }
+
+    *out_count = end - start + 1;
+    buffer->index[packet_id].in_nextsublayer = true; // Mark the packet as sent to the next sublayer
+    return &buffer->frames[start];
+}
+
 uint32_t get_first_packet_id(IOBuffer *buffer) {
-        for (uint32_t id = 0; id < NUM_MAX_SEGMENTS; id++) {
-            if (buffer->packet_id_in_use[id] && buffer->index[id].buffer_position == 0) {
-                return id; // Return the packet_id corresponding to the first element
+    if (buffer->first_packet == IO_INDEX_NONE) {
+        fprintf(stderr, "Error: No valid packet_id found for the first element.\n");
+        return NO_PACKET; // Indicate that no valid packet_id was found
+    }
+    return buffer->first_packet; // Oldest packet in the buffer
+}
+
+uint32_t get_next_packet_id(IOBuffer *buffer, uint32_t packet_id) {
+    if (!packet_id_is_used(buffer, packet_id) || buffer->index[packet_id].next_packet == IO_INDEX_NONE) {
+        return NO_PACKET;
+    }
+    return buffer->index[packet_id].next_packet;
+}
+
+// Aggregation of small packets (DFC_AGGREGATED frames)
+
+void aggregator_init(PacketAggregator *aggregator, IOBuffer *buffer, uint32_t max_delay_ms) {
+    memset(aggregator, 0, sizeof(PacketAggregator));
+    aggregator->buffer = buffer;
+    aggregator->max_delay_ms = max_delay_ms;
+}
+
+// Turn a bin into one frame in the IOBuffer. A bin holding a single packet is sent as a
+// plain DFC_PACKETS frame, without the length prefix.
+static bool aggregator_flush_bin(PacketAggregator *aggregator, AggregationBin *bin) {
+    SDUFrame frame;
+    uint32_t packet_id;
+    if (bin->count == 1) {
+        packet_id = store_unfragmented(bin->data + SIZE_AGGREGATION_LENGTH, bin->used - SIZE_AGGREGATION_LENGTH,
+            DFC_PACKETS, bin->port_id, bin->pdu_id, bin->sc_id, bin->sd_id, aggregator->buffer, &frame);
+    } else {
+        packet_id = store_unfragmented(bin->data, bin->used, DFC_AGGREGATED, bin->port_id, bin->pdu_id,
+            bin->sc_id, bin->sd_id, aggregator->buffer, &frame);
+    }
+    if (packet_id == UINT32_MAX) {
+        return false; // Keep the bin, it can be flushed again once the buffer has room
+    }
+    aggregator->frames_out++;
+    aggregator->packets_out += bin->count;
+    bin->in_use = false;
+    return true;
+}
+
+bool aggregator_add(PacketAggregator *aggregator, const uint8_t *OBC_data, size_t OBC_data_size, uint8_t PortID,
+    uint8_t PDU_ID, uint16_t SC_ID, uint8_t SD_ID, uint32_t now_ms) {
+    size_t needed = OBC_data_size + SIZE_AGGREGATION_LENGTH;
+    if (OBC_data == NULL || OBC_data_size == 0 || needed > MAX_UNFRAGMENTED_SDU_SIZE) {
+        fprintf(stderr, "Error: Packet cannot be aggregated.\n");
+        return false;
+    }
+
+    // First fit among the open bins with the same header fields
+    AggregationBin *target = NULL;
+    AggregationBin *free_bin = NULL;
+    AggregationBin *fullest = NULL;
+    for (size_t i = 0; i < AGGREGATOR_MAX_BINS; i++) {
+        AggregationBin *bin = &aggregator->bins[i];
+        if (!bin->in_use) {
+            if (free_bin == NULL) {
+                free_bin = bin;
             }
+            continue;
         }
-        fprintf(stderr, "Error: No valid packet_id found for the first element.\n");
-        return UINT32_MAX; // Indicate that no valid packet_id was found
+        if (bin->port_id == PortID && bin->pdu_id == PDU_ID && bin->sc_id == SC_ID && bin->sd_id == SD_ID &&
+            (size_t)(MAX_UNFRAGMENTED_SDU_SIZE - bin->used) >= needed) {
+            target = bin;
+            break;
+        }
+        if (fullest == NULL || bin->used > fullest->used) {
+            fullest = bin;
+        }
+    }
+
+    if (target == NULL) {
+        if (free_bin == NULL) {
+            // Every bin is open: send the fullest one to make room
+            if (!aggregator_flush_bin(aggregator, fullest)) {
+                return false;
+            }
+            free_bin = fullest;
+        }
+        target = free_bin;
+        target->in_use = true;
+        target->port_id = PortID;
+        target->pdu_id = PDU_ID;
+        target->sc_id = SC_ID;
+        target->sd_id = SD_ID;
+        target->count = 0;
+        target->used = 0;
+        target->deadline_ms = now_ms + aggregator->max_delay_ms;
+    }
+
+    target->data[target->used] = (uint8_t)OBC_data_size;
+    memcpy(target->data + target->used + SIZE_AGGREGATION_LENGTH, OBC_data, OBC_data_size);
+    target->used += (uint16_t)needed;
+    target->count++;
+    aggregator->packets_in++;
+    return true;
+}
+
+size_t aggregator_poll(PacketAggregator *aggregator, uint32_t now_ms) {
+    size_t flushed = 0;
+    for (size_t i = 0; i < AGGREGATOR_MAX_BINS; i++) {
+        AggregationBin *bin = &aggregator->bins[i];
+        if (!bin->in_use) {
+            continue;
+        }
+        // Due, or unable to take even a one-byte packet
+        bool due = (int32_t)(now_ms - bin->deadline_ms) >= 0;
+        bool full = MAX_UNFRAGMENTED_SDU_SIZE - bin->used < SIZE_AGGREGATION_LENGTH + 1;
+        if ((due || full) && aggregator_flush_bin(aggregator, bin)) {
+            flushed++;
+        }
+    }
+    return flushed;
+}
+
+size_t aggregator_flush_all(PacketAggregator *aggregator) {
+    size_t flushed = 0;
+    for (size_t i = 0; i < AGGREGATOR_MAX_BINS; i++) {
+        if (aggregator->bins[i].in_use && aggregator_flush_bin(aggregator, &aggregator->bins[i])) {
+            flushed++;
+        }
+    }
+    return flushed;
 }
 
 // I/O sublayer Rx
@@ -322,18 +1056,38 @@ bool need_more_seg(SDUFrame frame) {
     return true; // The frame is an intermediate or first segment   
 }
  void serialize_to_obc(SDUFrame frame, SerializedData* bufferserialized) {
+    PAE_PROFILE_SCOPE(PAE_PROBE_SERIALIZE_TO_OBC);
     if (frame.type == FRAME_UNFRAGMENTED) {
         // Copy only the data of the unfragmented SDU
         memcpy(bufferserialized->data, frame.data.unfragmented.sdu, frame.data.unfragmented.header.data_length_low);
         bufferserialized->length = frame.data.unfragmented.header.data_length_low;
+        PAE_PROFILE_BYTES(frame.data.unfragmented.header.data_length_low);
     } else if (frame.type == FRAME_FRAGMENTED) {
         // Add the data of the fragmented SDU at the end of bufferserialized->data (without headers)
         size_t segment_size = frame.data.fragmented.pdu_header.data_length_low;
         memcpy(bufferserialized->data + bufferserialized->length, frame.data.fragmented.sdu, segment_size);
         bufferserialized->length += segment_size;
+        PAE_PROFILE_BYTES(segment_size);
     }
 }
 
+bool aggregated_sdu_next(const uint8_t *sdu, size_t sdu_length, size_t *offset, const uint8_t **packet,
+    size_t *packet_length) {
+    if (sdu == NULL || offset == NULL || *offset + SIZE_AGGREGATION_LENGTH > sdu_length) {
+        return false; // End of the frame
+    }
+    size_t len = sdu[*offset];
+    size_t start = *offset + SIZE_AGGREGATION_LENGTH;
+    if (len == 0 || start + len > sdu_length) {
+        fprintf(stderr, "Error: Malformed aggregated SDU.\n");
+        return false;
+    }
+    *packet = sdu + start;
+    *packet_length = len;
+    *offset = start + len;
+    return true;
+}
+
 bitsecuence create_bitsecuence(SerializedData* bufferserialized) {
     bitsecuence bits = {0};
     size_t bit_index = 0;
@@ -360,3 +1114,230 @@ bitsecuence create_bitsecuence(SerializedData* bufferserialized) {
     return bits;
 }
 
+// Reassembly engine
+
+void reassembly_init(ReassemblyEngine *engine) {
+    memset(engine, 0, sizeof(ReassemblyEngine));
+}
+
+// Context of a packet being reassembled, or NULL; never allocates
+static ReassemblyContext* reassembly_find_context(ReassemblyEngine *engine, uint16_t sc_id,
+    uint8_t pseudo_packet_id) {
+    for (size_t i = 0; i < REASSEMBLY_MAX_CONTEXTS; i++) {
+        ReassemblyContext *ctx = &engine->contexts[i];
+        if (ctx->in_use && ctx->sc_id == sc_id && ctx->pseudo_packet_id == pseudo_packet_id) {
+            return ctx;
+        }
+    }
+    return NULL;
+}
+
+// True if the packet was completed recently: a late or resent segment of it must not open
+// a new context (that would report it missing again and deliver it twice)
+static bool reassembly_recently_completed(const ReassemblyEngine *engine, uint16_t sc_id,
+    uint8_t pseudo_packet_id, uint32_t now_ms) {
+    for (size_t i = 0; i < REASSEMBLY_RECENT_DEPTH; i++) {
+        const ReassemblyRecent *recent = &engine->recent[i];
+        if (recent->valid && recent->sc_id == sc_id && recent->pseudo_packet_id == pseudo_packet_id &&
+            (uint32_t)(now_ms - recent->completed_ms) <= REASSEMBLY_TIMEOUT_MS) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void reassembly_remember_completed(ReassemblyEngine *engine, uint16_t sc_id, uint8_t pseudo_packet_id,
+    uint32_t now_ms) {
+    ReassemblyRecent *recent = &engine->recent[engine->recent_next];
+    recent->valid = true;
+    recent->pseudo_packet_id = pseudo_packet_id;
+    recent->sc_id = sc_id;
+    recent->completed_ms = now_ms;
+    engine->recent_next = (engine->recent_next + 1) % REASSEMBLY_RECENT_DEPTH;
+}
+
+// Find the context of a packet, or take a free one (the least recently active if all are busy)
+static ReassemblyContext* reassembly_get_context(ReassemblyEngine *engine, uint16_t sc_id,
+    uint8_t pseudo_packet_id, uint32_t now_ms) {
+    ReassemblyContext *free_ctx = NULL;
+    ReassemblyContext *oldest = &engine->contexts[0];
+    for (size_t i = 0; i < REASSEMBLY_MAX_CONTEXTS; i++) {
+        ReassemblyContext *ctx = &engine->contexts[i];
+        if (!ctx->in_use) {
+            if (free_ctx == NULL) {
+                free_ctx = ctx;
+            }
+            continue;
+        }
+        if (ctx->sc_id == sc_id && ctx->pseudo_packet_id == pseudo_packet_id) {
+            return ctx;
+        }
+        if ((uint32_t)(now_ms - ctx->last_activity_ms) > (uint32_t)(now_ms - oldest->last_activity_ms)) {
+            oldest = ctx;
+        }
+    }
+    if (free_ctx == NULL) {
+        free_ctx = oldest;
+        engine->evicted++;
+    }
+
+    free_ctx->in_use = true;
+    free_ctx->sc_id = sc_id;
+    free_ctx->pseudo_packet_id = pseudo_packet_id;
+    free_ctx->num_segments = 0;
+    free_ctx->received_segments = 0;
+    free_ctx->sequenced = false;
+    free_ctx->has_first = false;
+    free_ctx->length = 0;
+    memset(free_ctx->received, 0, sizeof(free_ctx->received));
+    return free_ctx;
+}
+
+ReassemblyStatus reassembly_push(ReassemblyEngine *engine, const SDUFrame *frame, uint32_t now_ms,
+    SerializedData *out) {
+    if (frame == NULL || out == NULL || frame->type != FRAME_FRAGMENTED) {
+        return REASSEMBLY_ERROR;
+    }
+
+    const PDUHeader *hdr = &frame->data.fragmented.pdu_header;
+    const SegmentationHeader *seg = &frame->data.fragmented.seg_header;
+    size_t seg_len = ((size_t)hdr->data_length_high << 8) | hdr->data_length_low;
+
+    // A packet carried by a single segment needs no context
+    if (seg->SegFlag == NO_SEGMENT) {
+        out->data = frame->data.fragmented.sdu;
+        out->length = seg_len;
+        engine->completed++;
+        pae_metrics_reassembly_completed();
+        return REASSEMBLY_COMPLETE;
+    }
+
+    uint16_t sc_id = ((uint16_t)hdr->SC_ID_part1 << 8) | hdr->SC_ID_part2;
+    bool is_last = (seg->SegFlag == LAST_SEGMENT);
+    size_t index = hdr->FSN;
+    ReassemblyContext *ctx = reassembly_find_context(engine, sc_id, seg->PseudoPacketID);
+    if (ctx == NULL && reassembly_recently_completed(engine, sc_id, seg->PseudoPacketID, now_ms)) {
+        return REASSEMBLY_DUPLICATE;
+    }
+    if (hdr->QoS == SEQUENCED_CONTROLLEED) {
+        // COP-P numbers frames with V(S), so the segment index is relative to the first
+        // segment. FARM-P delivers in order, so the first segment always arrives first.
+        // Only the first segment opens a context: a stray continuation must not evict one.
+        if (seg->SegFlag == FIRST_SEGMENT) {
+            if (ctx == NULL) {
+                ctx = reassembly_get_context(engine, sc_id, seg->PseudoPacketID, now_ms);
+            }
+            if (ctx->has_first) {
+                return REASSEMBLY_DUPLICATE;
+            }
+            ctx->sequenced = true;
+            ctx->has_first = true;
+            ctx->first_fsn = hdr->FSN;
+        } else {
+            if (ctx == NULL || !ctx->has_first) {
+                return REASSEMBLY_ERROR; // Continuation without its first segment
+            }
+        }
+        index = (uint8_t)(hdr->FSN - ctx->first_fsn);
+    }
+
+    size_t offset = index * MAX_FRAGMENTED_SDU_SIZE;
+    if (index >= REASSEMBLY_MAX_SEGMENTS || offset + seg_len > REASSEMBLY_MAX_PACKET_SIZE ||
+        (!is_last && seg_len != MAX_FRAGMENTED_SDU_SIZE) || (seg->SegFlag == FIRST_SEGMENT && index != 0)) {
+        return REASSEMBLY_ERROR;
+    }
+
+    if (ctx == NULL) {
+        ctx = reassembly_get_context(engine, sc_id, seg->PseudoPacketID, now_ms);
+    }
+    ctx->last_activity_ms = now_ms;
+    ctx->last_report_ms = now_ms;
+
+    uint32_t bit = 1u << (index % 32);
+    if (ctx->received[index / 32] & bit) {
+        return REASSEMBLY_DUPLICATE;
+    }
+    if (ctx->num_segments != 0 && index >= ctx->num_segments) {
+        return REASSEMBLY_ERROR; // Beyond the last segment already received
+    }
+
+    // Place the segment directly at its final offset
+    memcpy(ctx->data + offset, frame->data.fragmented.sdu, seg_len);
+    ctx->received[index / 32] |= bit;
+    ctx->received_segments++;
+    if (is_last) {
+        ctx->num_segments = (uint16_t)(index + 1);
+        ctx->length = offset + seg_len;
+        // Segments stored beyond the last one do not belong to this packet: forget them,
+        // so that they cannot stand in for missing segments below the last
+        for (size_t i = ctx->num_segments; i < REASSEMBLY_MAX_SEGMENTS; i++) {
+            uint32_t beyond = 1u << (i % 32);
+            if (ctx->received[i / 32] & beyond) {
+                ctx->received[i / 32] &= ~beyond;
+                ctx->received_segments--;
+            }
+        }
+    }
+
+    if (ctx->num_segments == 0 || ctx->received_segments < ctx->num_segments) {
+        return REASSEMBLY_IN_PROGRESS;
+    }
+
+    out->data = ctx->data;
+    out->length = ctx->length;
+    ctx->in_use = false; // Data stays in place until the context is reused
+    reassembly_remember_completed(engine, sc_id, ctx->pseudo_packet_id, now_ms);
+    engine->completed++;
+    pae_metrics_reassembly_completed();
+    return REASSEMBLY_COMPLETE;
+}
+
+size_t reassembly_expire(ReassemblyEngine *engine, uint32_t now_ms) {
+    size_t expired = 0;
+    for (size_t i = 0; i < REASSEMBLY_MAX_CONTEXTS; i++) {
+        ReassemblyContext *ctx = &engine->contexts[i];
+        if (ctx->in_use && (uint32_t)(now_ms - ctx->last_activity_ms) >= REASSEMBLY_TIMEOUT_MS) {
+            ctx->in_use = false;
+            expired++;
+        }
+    }
+    engine->timeouts += expired;
+    pae_metrics_reassembly_timeouts(expired);
+    return expired;
+}
+
+size_t reassembly_pending(const ReassemblyEngine *engine) {
+    size_t pending = 0;
+    for (size_t i = 0; i < REASSEMBLY_MAX_CONTEXTS; i++) {
+        if (engine->contexts[i].in_use) {
+            pending++;
+        }
+    }
+    return pending;
+}
+
+bool reassembly_next_stalled(ReassemblyEngine *engine, size_t *cursor, uint32_t now_ms, uint32_t idle_ms,
+    uint16_t *sc_id, uint8_t *pseudo_packet_id, uint8_t *missing, size_t missing_bytes) {
+    for (; *cursor < REASSEMBLY_MAX_CONTEXTS; (*cursor)++) {
+        ReassemblyContext *ctx = &engine->contexts[*cursor];
+        if (!ctx->in_use || ctx->sequenced || (uint32_t)(now_ms - ctx->last_report_ms) < idle_ms) {
+            continue;
+        }
+
+        // Known segments: up to the last one if seen, else every index the bitmap can hold
+        size_t known = ctx->num_segments ? ctx->num_segments : REASSEMBLY_MAX_SEGMENTS;
+        memset(missing, 0, missing_bytes);
+        for (size_t i = 0; i < known && i / 8 < missing_bytes; i++) {
+            if ((ctx->received[i / 32] & (1u << (i % 32))) == 0) {
+                missing[i / 8] |= (uint8_t)(1u << (i % 8));
+            }
+        }
+
+        *sc_id = ctx->sc_id;
+        *pseudo_packet_id = ctx->pseudo_packet_id;
+        ctx->last_report_ms = now_ms;
+        (*cursor)++;
+        return true;
+    }
+    return false;
+}
@@ -12,21 +12,228 @@
 #define LAST_SEGMENT 0b10 // Last segment
 #define MIDDLE_SEGMENT 0b00 // Middle segment
 #define NO_SEGMENT 0b11 // No segment
+#define NO_PACKET UINT32_MAX // Returned when there is no packet_id
+
+// IOBuffer capacity, fixed at build time (-DIO_BUFFER_MAX_PACKETS=n ...).
+// The defaults keep the historical limits; shrink them to fit the mission's traffic.
+#ifndef IO_BUFFER_MAX_PACKETS
+#define IO_BUFFER_MAX_PACKETS NUM_MAX_SEGMENTS // Packets (packet_id) in the buffer at the same time
+#endif
+#ifndef IO_BUFFER_MAX_FRAMES
+#define IO_BUFFER_MAX_FRAMES NUM_MAX_SEGMENTS // Frame slots shared by all the packets in the buffer
+#endif
+#ifndef IO_BUFFER_INDEX_BITS // Width of the stored indices: 8 or 16, derived from the capacities by default
+#if IO_BUFFER_MAX_PACKETS <= 0xFF && IO_BUFFER_MAX_FRAMES <= 0xFF
+#define IO_BUFFER_INDEX_BITS 8
+#else
+#define IO_BUFFER_INDEX_BITS 16
+#endif
+#endif
+
+#if IO_BUFFER_INDEX_BITS == 8
+typedef uint8_t io_index_t;
+#define IO_INDEX_NONE 0xFF
+#elif IO_BUFFER_INDEX_BITS == 16
+typedef uint16_t io_index_t;
+#define IO_INDEX_NONE 0xFFFF
+#else
+#error "IO_BUFFER_INDEX_BITS must be 8 or 16"
+#endif
+
+#if IO_BUFFER_MAX_PACKETS < 1 || IO_BUFFER_MAX_PACKETS > IO_INDEX_NONE || \
+    IO_BUFFER_MAX_FRAMES < 1 || IO_BUFFER_MAX_FRAMES > IO_INDEX_NONE
+#error "IOBuffer capacities do not fit in IO_BUFFER_INDEX_BITS"
+#endif
+
+#define IO_BUFFER_BITMAP_WORDS ((IO_BUFFER_MAX_PACKETS + 31) / 32)
 
 typedef struct {
-    size_t buffer_position;  // Packet position in the buffer
-    size_t final_position;   // Final position of the packet in the buffer
-    bool in_nextsublayer;    // Indicates if the packet is in the next sublayer
+    io_index_t buffer_position;  // Packet position in the buffer
+    io_index_t final_position;   // Final position of the packet in the buffer
+    io_index_t prev_packet;      // Previous packet in arrival order (IO_INDEX_NONE if first)
+    io_index_t next_packet;      // Next packet in arrival order (IO_INDEX_NONE if last)
+    uint8_t in_nextsublayer : 1; // Indicates if the packet is in the next sublayer
+    uint8_t pinned : 1;          // SDU is owned by the caller, frames are slices into it
 } BufferIndexEntry;
 
+// `frames` is a ring: packets are appended at `tail` and always occupy contiguous
+// slots (a packet that does not fit before the end of the array starts again at 0).
+// Live packets are chained in arrival order, so releasing one only unlinks it; the
+// space is reclaimed when every older packet has been released as well.
 typedef struct {
-    SDUFrame frames[NUM_MAX_SEGMENTS]; // Array of SDUFrame with a maximum of NUM_MAX_SEGMENTS
-    BufferIndexEntry index[NUM_MAX_SEGMENTS]; // Array of indices to access the frames
-    bool packet_id_in_use[NUM_MAX_SEGMENTS]; // Record of packet_id in use (bitmap)
-    size_t completframes;               // Number of complete frames in the buffer
-    size_t size;                        // Number of frames currently in the array
+    SDUFrame frames[IO_BUFFER_MAX_FRAMES]; // Ring of SDUFrame shared by all the packets
+    BufferIndexEntry index[IO_BUFFER_MAX_PACKETS]; // Array of indices to access the frames
+    uint32_t packet_id_in_use[IO_BUFFER_BITMAP_WORDS]; // Bitmap of packet_id in use
+    uint16_t completframes;             // Number of complete packets in the buffer
+    uint16_t size;                      // Number of frames currently in the array
+    io_index_t tail;                    // Next free position in the ring
+    io_index_t first_packet;            // Oldest packet in the buffer (IO_INDEX_NONE if empty)
+    io_index_t last_packet;             // Newest packet in the buffer (IO_INDEX_NONE if empty)
 } IOBuffer; // Buffer to store segmented and non-segmented frames
 
+// Source callback for streaming segmentation: copy `len` bytes of the packet, starting
+// at `offset`, into `dst`. Returns the number of bytes copied.
+typedef size_t (*SegmentPullFn)(void *ctx, size_t offset, uint8_t *dst, size_t len);
+
+// Produces the segments of one packet on demand instead of storing them all in an IOBuffer.
+// Only one segment exists at a time: a view into `source`, or `scratch` filled by `pull`.
+typedef struct {
+    const uint8_t *source;   // Packet in memory (NULL when `pull` is used)
+    SegmentPullFn pull;      // Callback source (NULL when `source` is used)
+    void *pull_ctx;          // Argument passed to `pull`
+    size_t total_size;       // Packet size in bytes
+    size_t num_segments;     // Segments of the packet
+    size_t next_segment;     // Index (FSN) of the next segment to produce
+    uint8_t pseudo_packet_id;
+    uint8_t port_id;
+    uint8_t pdu_id;
+    uint16_t sc_id;
+    uint8_t sd_id;
+    uint8_t scratch[MAX_FRAGMENTED_SDU_SIZE]; // Segment pulled from `pull`
+} SegmentIterator;
+
+// Erasure-coded segmentation for links without a return channel.
+// A packet of k data segments is sent as n = k + m segments: the k data segments followed by
+// m repair segments of a systematic Cauchy Reed-Solomon code over GF(256), applied byte by byte
+// across the segments. Any k of the n segments rebuild the packet. The repair overhead
+// (m as a percentage of k) is set per port with erasure_set_port_overhead(); both ends must
+// use the same table. Each coded segment starts with an erasure header.
+#define SIZE_ERASURE_HEADER 4 // [segment index][k][packet length high][packet length low]
+#define ERASURE_SEGMENT_SIZE (MAX_FRAGMENTED_SDU_SIZE - SIZE_ERASURE_HEADER) // Packet bytes per segment
+#define ERASURE_MAX_TOTAL_SEGMENTS 255 // k + m, limited by the field size and the FSN
+// Largest packet the receiver can rebuild, and so the largest the sender will code: with the
+// default 4096 bytes a packet has at most ERASURE_MAX_DATA_SEGMENTS = 20 data segments, well
+// below the k + m <= 255 the code allows. Raising it grows the decoder by the same amount.
+#ifndef ERASURE_MAX_PACKET_SIZE
+#define ERASURE_MAX_PACKET_SIZE 4096
+#endif
+#define ERASURE_MAX_DATA_SEGMENTS ((ERASURE_MAX_PACKET_SIZE + ERASURE_SEGMENT_SIZE - 1) / ERASURE_SEGMENT_SIZE)
+
+#if ERASURE_MAX_DATA_SEGMENTS >= ERASURE_MAX_TOTAL_SEGMENTS
+#error "ERASURE_MAX_PACKET_SIZE needs more segments than the code can carry"
+#endif
+#if ERASURE_MAX_PACKET_SIZE > 0xFFFF
+#error "ERASURE_MAX_PACKET_SIZE must fit the 16-bit packet length of the erasure header"
+#endif
+
+// Produces the n coded segments of one packet on demand. Repair segments are computed
+// from `source` into `scratch` when they are requested.
+typedef struct {
+    const uint8_t *source;   // Packet in memory
+    size_t total_size;       // Packet size in bytes
+    uint8_t k;               // Data segments
+    uint8_t n;               // Data + repair segments
+    uint8_t next_segment;    // Index of the next segment to produce
+    uint8_t pseudo_packet_id;
+    uint8_t port_id;
+    uint8_t pdu_id;
+    uint16_t sc_id;
+    uint8_t sd_id;
+    uint8_t scratch[MAX_FRAGMENTED_SDU_SIZE]; // Erasure header and segment data
+} ErasureIterator;
+
+// Rebuilds one packet at a time. Each slot holds a data segment, or a repair segment parked
+// in the slot of a data segment that has not arrived.
+typedef struct {
+    bool in_use;
+    bool complete;           // Packet delivered; later segments of it are duplicates
+    uint8_t pseudo_packet_id;
+    uint16_t sc_id;
+    uint8_t k;
+    uint16_t length;         // Packet length from the erasure header
+    uint16_t received;       // Distinct segments received
+    uint32_t last_activity_ms; // Time of the last segment, for erasure_expire()
+    uint8_t slot_segment[ERASURE_MAX_DATA_SEGMENTS]; // Segment index held by each slot (0xFF: empty)
+    uint8_t data[ERASURE_MAX_DATA_SEGMENTS * ERASURE_SEGMENT_SIZE];
+    uint32_t decoded;        // Packets delivered
+    uint32_t recovered;      // Data segments rebuilt from repair segments
+    uint32_t timeouts;       // Packets dropped by erasure_expire()
+} ErasureDecoder;
+
+// Aggregation of small packets into a single DFC_AGGREGATED frame.
+// Packets with the same header fields are packed first-fit into open bins; a bin becomes a
+// frame when its deadline passes, when it is full, or when its slot is needed for a new bin.
+#ifndef AGGREGATOR_MAX_BINS
+#define AGGREGATOR_MAX_BINS 4 // Frames being filled at the same time
+#endif
+
+typedef struct {
+    bool in_use;
+    uint8_t port_id;
+    uint8_t pdu_id;
+    uint16_t sc_id;
+    uint8_t sd_id;
+    uint8_t count;          // Packets in the bin
+    uint16_t used;          // Bytes used in `data`
+    uint32_t deadline_ms;   // Time at which the bin must be sent
+    uint8_t data[MAX_UNFRAGMENTED_SDU_SIZE]; // [length][packet] records
+} AggregationBin;
+
+typedef struct {
+    AggregationBin bins[AGGREGATOR_MAX_BINS];
+    IOBuffer *buffer;       // Destination of the aggregated frames
+    uint32_t max_delay_ms;  // Latency budget of the first packet of a bin
+    uint32_t packets_in;    // Packets accepted
+    uint32_t packets_out;   // Packets sent in frames
+    uint32_t frames_out;    // Frames produced
+} PacketAggregator;
+
+// Reassembly of fragmented packets on reception, several packets at a time.
+// A packet is identified by (SC_ID, PseudoPacketID); the FSN of an Expedited segment is its
+// index, the FSN of a Sequence Controlled segment counts from the FSN of the first segment.
+#ifndef REASSEMBLY_MAX_CONTEXTS
+#define REASSEMBLY_MAX_CONTEXTS 4 // Packets being reassembled at the same time
+#endif
+#ifndef REASSEMBLY_MAX_PACKET_SIZE
+#define REASSEMBLY_MAX_PACKET_SIZE 2048 // Largest packet that can be reassembled
+#endif
+#ifndef REASSEMBLY_TIMEOUT_MS
+#define REASSEMBLY_TIMEOUT_MS 30000 // Drop a packet that received no segment for this long
+#endif
+#ifndef REASSEMBLY_RECENT_DEPTH
+#define REASSEMBLY_RECENT_DEPTH 8 // Completed packets remembered to drop their late segments (< 64 PseudoPacketIDs)
+#endif
+#define REASSEMBLY_MAX_SEGMENTS ((REASSEMBLY_MAX_PACKET_SIZE + MAX_FRAGMENTED_SDU_SIZE - 1) / MAX_FRAGMENTED_SDU_SIZE)
+
+typedef enum {
+    REASSEMBLY_IN_PROGRESS = 0, // Segment stored, more segments needed
+    REASSEMBLY_COMPLETE = 1,    // Packet complete, returned in `out`
+    REASSEMBLY_DUPLICATE = 2,   // Segment already received, ignored
+    REASSEMBLY_ERROR = 3        // Segment rejected (not fragmented, out of range, inconsistent size)
+} ReassemblyStatus;
+
+typedef struct {
+    bool in_use;
+    uint8_t pseudo_packet_id;    // PseudoPacketID of the packet
+    uint16_t sc_id;              // Spacecraft ID of the sender
+    uint16_t num_segments;       // Known once the last segment arrives (0 = unknown)
+    uint16_t received_segments;  // Number of distinct segments received
+    bool sequenced;              // Sequence Controlled packet (repaired by COP-P, not by NACKs)
+    bool has_first;              // Sequence Controlled: first segment seen, `first_fsn` is valid
+    uint8_t first_fsn;           // Sequence Controlled: FSN of the first segment
+    size_t length;               // Packet length, known once the last segment arrives
+    uint32_t last_activity_ms;   // Time of the last accepted segment
+    uint32_t last_report_ms;     // Time of the last segment or missing-segment report
+    uint32_t received[(REASSEMBLY_MAX_SEGMENTS + 31) / 32]; // Bitmap of received segments
+    uint8_t data[REASSEMBLY_MAX_PACKET_SIZE]; // Segment n is written at n * MAX_FRAGMENTED_SDU_SIZE
+} ReassemblyContext;
+
+typedef struct {
+    bool valid;
+    uint8_t pseudo_packet_id;
+    uint16_t sc_id;
+    uint32_t completed_ms; // Forgotten after REASSEMBLY_TIMEOUT_MS, e.g. if the sender restarts its IDs
+} ReassemblyRecent;
+
+typedef struct {
+    ReassemblyContext contexts[REASSEMBLY_MAX_CONTEXTS];
+    ReassemblyRecent recent[REASSEMBLY_RECENT_DEPTH]; // Last packets completed, oldest overwritten first
+    size_t recent_next;
+    uint32_t completed;  // Packets delivered
+    uint32_t timeouts;   // Packets dropped by reassembly_expire()
+    uint32_t evicted;    // Packets dropped to make room for a new one
+} ReassemblyEngine;
+
 // Function declarations
 
 bool need_fragmentation(uint8_t *OBC_data, size_t OBC_data_size);
@@ -38,30 +245,136 @@ SegmentationHeader create_segmentation_header(uint8_t seg_flag, uint8_t pseudo_p
 
 void create_buffer(IOBuffer *buffer);
 
+// sizeof(IOBuffer) for the capacities this library was built with
+size_t io_buffer_footprint(void);
+
+bool packet_id_is_used(const IOBuffer *buffer, uint32_t packet_id);
+
 uint32_t generate_packet_id(IOBuffer *buffer);
 
 void release_packet_id(IOBuffer *buffer, uint32_t packet_id);
 
+// Copies each segment into an SDU pool block: a packet takes as many blocks as segments,
+// up to IO_BUFFER_MAX_FRAMES (the pool is sized for that, see sdu_pool.h).
 IOBuffer segment_sdu(uint8_t *OBC_data, size_t OBC_data_size, uint8_t PortID, uint8_t PDU_ID,
     uint16_t SC_ID, uint8_t SD_ID, IOBuffer *buffer);
 
 SDUFrame create_unfragmented_sdu(uint8_t *OBC_data, size_t OBC_data_size, uint8_t PortID,
     uint8_t PDU_ID, uint16_t SC_ID, uint8_t SD_ID, IOBuffer *buffer);
 
+// Zero-copy variants: the frames stored in the buffer point directly into OBC_data,
+// which the caller must keep alive and unmodified until free_buffer() releases the packet.
+// Return the packet_id of the new entry, or UINT32_MAX on error.
+uint32_t segment_sdu_pinned(uint8_t *OBC_data, size_t OBC_data_size, uint8_t PortID, uint8_t PDU_ID,
+    uint16_t SC_ID, uint8_t SD_ID, IOBuffer *buffer);
+
+uint32_t create_unfragmented_sdu_pinned(uint8_t *OBC_data, size_t OBC_data_size, uint8_t PortID,
+    uint8_t PDU_ID, uint16_t SC_ID, uint8_t SD_ID, IOBuffer *buffer);
+
 void free_buffer(IOBuffer *buffer, uint32_t packet_id);
 
+// Erasure-coded segmentation. The overhead is the number of repair segments as a percentage
+// of the data segments (rounded up); 0 turns the port back to plain segmentation.
+void erasure_set_port_overhead(uint8_t PortID, uint8_t percent);
+uint8_t erasure_port_overhead(uint8_t PortID);
+// Start producing the coded segments of OBC_data; the data must stay valid while iterating.
+// Fails if the port has no overhead configured or the packet is larger than ERASURE_MAX_PACKET_SIZE.
+bool erasure_iterator_init(ErasureIterator *it, const uint8_t *OBC_data, size_t OBC_data_size, uint8_t PortID,
+    uint8_t PDU_ID, uint16_t SC_ID, uint8_t SD_ID);
+// Next coded segment; its SDU points into `it->source` or `it->scratch`, valid until the next call
+bool erasure_iterator_next(ErasureIterator *it, SDUFrame *frame);
+
+void erasure_decoder_init(ErasureDecoder *decoder);
+// Store a coded segment. On REASSEMBLY_COMPLETE `out` points to the packet inside the
+// decoder; it stays valid until the next call.
+ReassemblyStatus erasure_push(ErasureDecoder *decoder, const SDUFrame *frame, uint32_t now_ms, SerializedData *out);
+// Release the packet once it received no segment for REASSEMBLY_TIMEOUT_MS. Returns 1 if it
+// was still incomplete (dropped), 0 otherwise.
+size_t erasure_expire(ErasureDecoder *decoder, uint32_t now_ms);
+
+void aggregator_init(PacketAggregator *aggregator, IOBuffer *buffer, uint32_t max_delay_ms);
+
+// Queue a small packet (up to MAX_UNFRAGMENTED_SDU_SIZE - SIZE_AGGREGATION_LENGTH bytes).
+// The data is copied. Returns false if the packet is too large or no bin could be freed.
+bool aggregator_add(PacketAggregator *aggregator, const uint8_t *OBC_data, size_t OBC_data_size, uint8_t PortID,
+    uint8_t PDU_ID, uint16_t SC_ID, uint8_t SD_ID, uint32_t now_ms);
+
+// Move the bins that are due or full to the IOBuffer. Returns the number of frames produced.
+size_t aggregator_poll(PacketAggregator *aggregator, uint32_t now_ms);
+
+// Move every open bin to the IOBuffer. Returns the number of frames produced.
+size_t aggregator_flush_all(PacketAggregator *aggregator);
+
+// Streaming segmentation. The iterator yields the same frames as segment_sdu(), one at a time:
+// the frame returned by segment_iterator_next() is valid until the next call, and its SDU is
+// either a view into OBC_data or the iterator's scratch buffer. Init functions return false on error.
+bool segment_iterator_init(SegmentIterator *it, const uint8_t *OBC_data, size_t OBC_data_size, uint8_t PortID,
+    uint8_t PDU_ID, uint16_t SC_ID, uint8_t SD_ID);
+
+bool segment_iterator_init_pull(SegmentIterator *it, SegmentPullFn pull, void *pull_ctx, size_t OBC_data_size,
+    uint8_t PortID, uint8_t PDU_ID, uint16_t SC_ID, uint8_t SD_ID);
+
+// Returns false when every segment has been produced or the source failed
+bool segment_iterator_next(SegmentIterator *it, SDUFrame *frame);
+
+bool segment_iterator_done(const SegmentIterator *it);
+
 // Prepare a copy of the frames associated with `packet_id` for the next sublayer.
-// The function allocates an array of SDUFrame and duplicates per-frame SDU bytes.
+// The function allocates an array of SDUFrame and duplicates per-frame SDU bytes into SDU pool blocks.
+// The copy needs as many free blocks as the packet has segments, on top of the blocks of the
+// stored packet: for large packets use move_to_next_sublayer() or get_packet_frames().
 // On success returns the allocated SDUFrame* and writes the number of elements to *out_count.
-// The caller is responsible for freeing the returned frames and their internal SDU buffers.
+// The caller is responsible for freeing the returned array (free) and its SDU buffers (sdu_pool_free).
 // On error returns NULL and *out_count is set to 0.
 SDUFrame* send_to_next_sublayer(IOBuffer *buffer, uint32_t packet_id, size_t *out_count);
 
+// Same contract as send_to_next_sublayer(), but the SDUs are moved instead of duplicated:
+// only the SDUFrame array is allocated and the buffer gives up its SDU pointers. The caller
+// then owns both: free() the array and sdu_pool_free() each SDU once the frames are sent.
+// The packet stays in the buffer, marked in the next sublayer, until free_buffer().
+// Pinned packets (whose SDUs belong to the caller) are copied as in send_to_next_sublayer().
+SDUFrame* move_to_next_sublayer(IOBuffer *buffer, uint32_t packet_id, size_t *out_count);
+
+// Borrowed view of the frames associated with `packet_id`, stored inside the buffer.
+// Nothing is copied: the frames (and their SDU pointers) stay valid until free_buffer().
+// The caller must not free or modify them. Marks the packet as in the next sublayer.
+// On error returns NULL and *out_count is set to 0.
+const SDUFrame* get_packet_frames(IOBuffer *buffer, uint32_t packet_id, size_t *out_count);
+
+// Oldest packet in the buffer, O(1). NO_PACKET if the buffer is empty.
 uint32_t get_first_packet_id(IOBuffer *buffer);
 
+// Packet queued right after `packet_id` (arrival order), O(1). NO_PACKET if it is the newest.
+uint32_t get_next_packet_id(IOBuffer *buffer, uint32_t packet_id);
+
 bool need_more_seg(SDUFrame frame);
 
 void serialize_to_obc(SDUFrame frame, SerializedData* bufferserialized);
 
+// Iterate over the packets of a DFC_AGGREGATED SDU. Start with *offset = 0; each call
+// returns the next packet (a view into `sdu`) and advances *offset. False at the end.
+bool aggregated_sdu_next(const uint8_t *sdu, size_t sdu_length, size_t *offset, const uint8_t **packet,
+    size_t *packet_length);
+
 bitsecuence create_bitsecuence(SerializedData* bufferserialized);
+
+void reassembly_init(ReassemblyEngine *engine);
+
+// Store a received fragmented frame. On REASSEMBLY_COMPLETE `out` points to the whole
+// packet inside the engine; it stays valid until the next call on the engine.
+ReassemblyStatus reassembly_push(ReassemblyEngine *engine, const SDUFrame *frame, uint32_t now_ms,
+    SerializedData *out);
+
+// Drop the packets that received no segment for REASSEMBLY_TIMEOUT_MS. Returns how many.
+size_t reassembly_expire(ReassemblyEngine *engine, uint32_t now_ms);
+
+// Number of packets being reassembled
+size_t reassembly_pending(const ReassemblyEngine *engine);
+
+// Find the next Expedited packet, from context *cursor on, that has received nothing for
+// `idle_ms` since its last segment or report. Fills `missing` with one bit per segment
+// (LSB first, 1 = missing); segments after the highest one received are reported missing
+// until the last segment is seen. Returns false when there are no more.
+bool reassembly_next_stalled(ReassemblyEngine *engine, size_t *cursor, uint32_t now_ms, uint32_t idle_ms,
+    uint16_t *sc_id, uint8_t *pseudo_packet_id, uint8_t *missing, size_t missing_bytes);
 #endif // IO_SUBLAYER_H
\ No newline at end of file
@@ -0,0 +1,50 @@
+#include "lora_airtime.h"
+
+#include <stddef.h>
+
+bool lora_ldro_required(uint8_t spreading_factor, uint32_t bandwidth_hz) {
+    // Tsym = 2^SF / BW >= 16 ms
+    return bandwidth_hz > 0 && ((uint64_t)1000 << spreading_factor) >= (uint64_t)16 * bandwidth_hz;
+}
+
+uint32_t lora_symbol_time_us(const LoRaParams *params) {
+    if (params == NULL || params->bandwidth_hz == 0) {
+        return 0;
+    }
+    return (uint32_t)(((uint64_t)1000000 << params->spreading_factor) / params->bandwidth_hz);
+}
+
+uint32_t lora_time_on_air_us(const LoRaParams *params, uint8_t payload_length) {
+    if (params == NULL || params->bandwidth_hz == 0 || params->spreading_factor < 5 ||
+        params->spreading_factor > 12 || params->coding_rate < 1 || params->coding_rate > 4) {
+        return 0;
+    }
+    int32_t sf = params->spreading_factor;
+    int32_t crc = params->crc_on ? 1 : 0;
+    int32_t header = params->implicit_header ? 0 : 1;
+
+    // Counted in quarter symbols so the 4.25 / 6.25 preamble tail stays exact
+    int32_t bits;
+    int32_t bits_per_symbol;
+    uint32_t quarter_symbols;
+    if (sf < 7) {
+        // SF5 and SF6: longer sync word, no LDRO, no 8-bit offset
+        bits = 8 * payload_length + 16 * crc - 4 * sf + 20 * header;
+        bits_per_symbol = 4 * sf;
+        quarter_symbols = (uint32_t)params->preamble_symbols * 4 + 25;
+    } else {
+        bits = 8 * payload_length + 16 * crc - 4 * sf + 8 + 20 * header;
+        bits_per_symbol = 4 * (sf - (params->low_data_rate ? 2 : 0));
+        quarter_symbols = (uint32_t)params->preamble_symbols * 4 + 17;
+    }
+    int32_t blocks = (bits > 0) ? (bits + bits_per_symbol - 1) / bits_per_symbol : 0;
+    uint32_t payload_symbols = 8 + (uint32_t)blocks * (params->coding_rate + 4);
+    quarter_symbols += payload_symbols * 4;
+
+    // quarter_symbols / 4 * 2^SF / BW, in microseconds
+    return (uint32_t)(((uint64_t)quarter_symbols * 250000 << sf) / params->bandwidth_hz);
+}
+
+uint32_t lora_frame_interval_ms(const LoRaParams *params, uint8_t payload_length, uint32_t turnaround_ms) {
+    return (lora_time_on_air_us(params, payload_length) + 999) / 1000 + turnaround_ms;
+}
@@ -0,0 +1,39 @@
+#ifndef LORA_AIRTIME_H
+#define LORA_AIRTIME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// LoRa time-on-air model (Semtech SX126x/LR11xx datasheet formula), so the link layer can
+// pace frames at the channel rate instead of using fixed delays. Independent of the radio
+// driver: the application maps its radio configuration into LoRaParams.
+typedef struct {
+    uint8_t spreading_factor;   // 5 .. 12
+    uint32_t bandwidth_hz;      // e.g. 125000
+    uint8_t coding_rate;        // 1 .. 4 for 4/5 .. 4/8
+    uint16_t preamble_symbols;  // Programmed preamble length
+    bool implicit_header;
+    bool crc_on;
+    bool low_data_rate;         // Low data rate optimization (see lora_ldro_required())
+} LoRaParams;
+
+// Time the receiver needs between the end of one frame and being back in RX for the next:
+// frame processing, logging and the RX set-up. Added after every frame.
+#ifndef LORA_RX_TURNAROUND_MS
+#define LORA_RX_TURNAROUND_MS 100
+#endif
+
+// Low data rate optimization is mandatory when a symbol lasts 16 ms or more
+bool lora_ldro_required(uint8_t spreading_factor, uint32_t bandwidth_hz);
+
+// Duration of one symbol in microseconds
+uint32_t lora_symbol_time_us(const LoRaParams *params);
+
+// Time on air of a packet of `payload_length` bytes, in microseconds
+uint32_t lora_time_on_air_us(const LoRaParams *params, uint8_t payload_length);
+
+// Minimum time between the starts of two consecutive frames: time on air rounded up to
+// the millisecond plus the receiver turnaround
+uint32_t lora_frame_interval_ms(const LoRaParams *params, uint8_t payload_length, uint32_t turnaround_ms);
+
+#endif // LORA_AIRTIME_H
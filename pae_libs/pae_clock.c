@@ -0,0 +1,63 @@
+#include "pae_clock.h"
+
+#if defined(__arm__)
+#include "stm32l4xx.h"
+
+static uint32_t last_cycles = 0;   // CYCCNT at the previous call
+static uint64_t total_cycles = 0;  // Cycles elapsed since pae_clock_init()
+
+void pae_clock_init(void) {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; // Enable the trace block (DWT)
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    last_cycles = 0;
+    total_cycles = 0;
+}
+
+uint32_t pae_clock_ms(void) {
+    uint32_t now = DWT->CYCCNT;
+    total_cycles += (uint32_t)(now - last_cycles); // Unsigned difference survives one wrap
+    last_cycles = now;
+    return (uint32_t)(total_cycles / (SystemCoreClock / 1000u));
+}
+
+uint32_t pae_clock_ticks(void) {
+    return DWT->CYCCNT;
+}
+
+uint32_t pae_clock_ticks_per_us(void) {
+    return SystemCoreClock / 1000000u;
+}
+
+uint32_t pae_clock_ms_at(uint32_t ticks) {
+    uint32_t now_ms = pae_clock_ms();
+    return now_ms - (uint32_t)(last_cycles - ticks) / (SystemCoreClock / 1000u);
+}
+
+#else
+#include <time.h>
+
+void pae_clock_init(void) {
+}
+
+uint32_t pae_clock_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u);
+}
+
+uint32_t pae_clock_ticks(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
+
+uint32_t pae_clock_ticks_per_us(void) {
+    return 1000u;
+}
+
+uint32_t pae_clock_ms_at(uint32_t ticks) {
+    uint32_t now_ms = pae_clock_ms();
+    return now_ms - (pae_clock_ticks() - ticks) / 1000000u;
+}
+#endif
@@ -0,0 +1,23 @@
+#ifndef PAE_CLOCK_H
+#define PAE_CLOCK_H
+
+#include <stdint.h>
+
+// Monotonic millisecond clock used for protocol timeouts.
+// On the STM32L4 it is built on the DWT cycle counter, which wraps every 2^32 cycles
+// (about 53 s at 80 MHz): pae_clock_ms() must be called at least once per wrap period.
+// On the host it reads CLOCK_MONOTONIC.
+void pae_clock_init(void);
+uint32_t pae_clock_ms(void);
+
+// Raw tick counter for short measurements (see pae_profile.h): CPU cycles on the STM32L4,
+// nanoseconds on the host. Wraps at 2^32 ticks; differences of two reads stay valid below that.
+uint32_t pae_clock_ticks(void);
+uint32_t pae_clock_ticks_per_us(void);
+
+// pae_clock_ms() time of an earlier pae_clock_ticks() read, taken less than one wrap ago.
+// pae_clock_ticks() is interrupt safe and pae_clock_ms() is not: an interrupt handler
+// stamps events with ticks and the main loop converts them with this.
+uint32_t pae_clock_ms_at(uint32_t ticks);
+
+#endif // PAE_CLOCK_H
@@ -0,0 +1,148 @@
+#include "pae_metrics.h"
+
+#include <string.h>
+
+PaeMetrics pae_metrics;
+
+void pae_metrics_reset(void) {
+    memset(&pae_metrics, 0, sizeof(PaeMetrics));
+}
+
+void pae_metrics_histogram_add(PaeHistogram *histogram, uint32_t value) {
+    uint32_t scaled = value / PAE_METRICS_LATENCY_BASE_MS;
+    uint32_t bucket = (scaled == 0) ? 0 : 32u - (uint32_t)__builtin_clz(scaled);
+    if (bucket >= PAE_METRICS_LATENCY_BUCKETS) {
+        bucket = PAE_METRICS_LATENCY_BUCKETS - 1;
+    }
+    histogram->buckets[bucket]++;
+    histogram->count++;
+    if (value > histogram->max) {
+        histogram->max = value;
+    }
+}
+
+// Snapshot coding
+
+typedef struct {
+    uint8_t *data;
+    size_t length;
+    size_t capacity;
+    bool overflow;
+} MetricsWriter;
+
+typedef struct {
+    const uint8_t *data;
+    size_t length;
+    size_t offset;
+    bool truncated;
+} MetricsReader;
+
+static void put_varint(MetricsWriter *w, uint32_t value) {
+    do {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        if (w->length == w->capacity) {
+            w->overflow = true;
+            return;
+        }
+        w->data[w->length++] = byte | (value != 0 ? 0x80 : 0x00);
+    } while (value != 0);
+}
+
+static uint32_t get_varint(MetricsReader *r) {
+    uint32_t value = 0;
+    for (unsigned shift = 0; shift < 35; shift += 7) {
+        if (r->offset == r->length) {
+            r->truncated = true;
+            return 0;
+        }
+        uint8_t byte = r->data[r->offset++];
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+    r->truncated = true; // More than 5 bytes: not a 32-bit value
+    return 0;
+}
+
+size_t pae_metrics_snapshot(uint8_t *out, size_t capacity) {
+    const PaeFrameMetrics *frame = &pae_metrics.frame;
+    if (out == NULL || capacity < 2) {
+        return 0;
+    }
+
+    uint8_t port_mask = 0;
+    for (size_t p = 0; p < NUM_PORTS; p++) {
+        if (frame->tx[p].frames != 0 || frame->rx[p].frames != 0) {
+            port_mask |= (uint8_t)(1u << p);
+        }
+    }
+
+    MetricsWriter w = {out, 0, capacity, false};
+    out[w.length++] = PAE_METRICS_VERSION;
+    out[w.length++] = port_mask;
+    for (size_t p = 0; p < NUM_PORTS; p++) {
+        if (port_mask & (1u << p)) {
+            put_varint(&w, frame->tx[p].frames);
+            put_varint(&w, frame->tx[p].bytes);
+            put_varint(&w, frame->rx[p].frames);
+            put_varint(&w, frame->rx[p].bytes);
+        }
+    }
+    put_varint(&w, frame->invalid_frames);
+    put_varint(&w, frame->queue_depth);
+    put_varint(&w, frame->queue_high_water);
+    put_varint(&w, frame->tx_latency_ms.count);
+    put_varint(&w, frame->tx_latency_ms.max);
+    put_varint(&w, PAE_METRICS_LATENCY_BUCKETS);
+    for (size_t b = 0; b < PAE_METRICS_LATENCY_BUCKETS; b++) {
+        put_varint(&w, frame->tx_latency_ms.buckets[b]);
+    }
+    put_varint(&w, pae_metrics.io.reassembly_completed);
+    put_varint(&w, pae_metrics.io.reassembly_timeouts);
+
+    return w.overflow ? 0 : w.length;
+}
+
+bool pae_metrics_parse(const uint8_t *data, size_t length, PaeMetrics *out) {
+    if (data == NULL || out == NULL || length < 2 || data[0] != PAE_METRICS_VERSION) {
+        return false;
+    }
+
+    PaeMetrics metrics;
+    memset(&metrics, 0, sizeof(PaeMetrics));
+    PaeFrameMetrics *frame = &metrics.frame;
+    MetricsReader r = {data, length, 2, false};
+    uint8_t port_mask = data[1];
+    for (size_t p = 0; p < NUM_PORTS; p++) {
+        if (port_mask & (1u << p)) {
+            frame->tx[p].frames = get_varint(&r);
+            frame->tx[p].bytes = get_varint(&r);
+            frame->rx[p].frames = get_varint(&r);
+            frame->rx[p].bytes = get_varint(&r);
+        }
+    }
+    frame->invalid_frames = get_varint(&r);
+    frame->queue_depth = get_varint(&r);
+    frame->queue_high_water = get_varint(&r);
+    frame->tx_latency_ms.count = get_varint(&r);
+    frame->tx_latency_ms.max = get_varint(&r);
+    uint32_t buckets = get_varint(&r);
+    if (r.truncated || buckets > r.length - r.offset) {
+        return false; // Every bucket takes at least one byte
+    }
+    for (uint32_t b = 0; b < buckets && !r.truncated; b++) {
+        // A sender built with more buckets folds its tail into our last one
+        uint32_t value = get_varint(&r);
+        frame->tx_latency_ms.buckets[b < PAE_METRICS_LATENCY_BUCKETS ? b : PAE_METRICS_LATENCY_BUCKETS - 1] += value;
+    }
+    metrics.io.reassembly_completed = get_varint(&r);
+    metrics.io.reassembly_timeouts = get_varint(&r);
+
+    if (r.truncated) {
+        return false;
+    }
+    *out = metrics;
+    return true;
+}
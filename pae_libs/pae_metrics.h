@@ -0,0 +1,149 @@
+#ifndef PAE_METRICS_H
+#define PAE_METRICS_H
+
+#include "protocol_definitions.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Protocol metrics: counters, gauges and fixed-bucket histograms kept per sublayer in one
+// global registry. The sublayers update it from their hot paths with the inline helpers
+// below (a few instructions each, no lock: every field has a single writer, either the
+// main loop or the radio interrupt). pae_metrics_snapshot() packs the registry into a
+// compact little-endian dump for the UART or for a command PDU (see metrics_frame()).
+// Build with -DPAE_METRICS_ENABLED=0 to compile every update out.
+#ifndef PAE_METRICS_ENABLED
+#define PAE_METRICS_ENABLED 1
+#endif
+
+// Latency histogram: bucket 0 counts values below PAE_METRICS_LATENCY_BASE_MS, bucket i
+// values below PAE_METRICS_LATENCY_BASE_MS << i, and the last bucket everything above.
+#ifndef PAE_METRICS_LATENCY_BUCKETS
+#define PAE_METRICS_LATENCY_BUCKETS 12 // 16 ms .. 16 s with the default base
+#endif
+#ifndef PAE_METRICS_LATENCY_BASE_MS
+#define PAE_METRICS_LATENCY_BASE_MS 16
+#endif
+
+#if PAE_METRICS_LATENCY_BUCKETS < 2 || PAE_METRICS_LATENCY_BUCKETS > 32
+#error "PAE_METRICS_LATENCY_BUCKETS must be between 2 and 32"
+#endif
+
+// Snapshot format, version PAE_METRICS_VERSION. Every value is an unsigned LEB128 varint
+// (7 bits per byte, low bits first), so idle counters take one byte:
+//   [version][port mask]
+//   for each port set in the mask: [tx frames][tx bytes][rx frames][rx bytes]
+//   [invalid frames][queue depth][queue high water]
+//   [latency count][latency max][bucket count][buckets...]
+//   [reassembly completed][reassembly timeouts]
+#define PAE_METRICS_VERSION 1
+#define PAE_METRICS_SNAPSHOT_MAX (2 + (4 * NUM_PORTS + 8 + PAE_METRICS_LATENCY_BUCKETS) * 5)
+
+typedef struct {
+    uint32_t frames;
+    uint32_t bytes;  // Serialized frame bytes (headers, SDU and FCS, without FEC parity)
+} PaePortCounters;
+
+typedef struct {
+    uint32_t buckets[PAE_METRICS_LATENCY_BUCKETS];
+    uint32_t count;
+    uint32_t max;
+} PaeHistogram;
+
+// Frame sublayer
+typedef struct {
+    PaePortCounters tx[NUM_PORTS]; // Frames that reached TX_DONE (radio interrupt)
+    PaePortCounters rx[NUM_PORTS]; // Frames accepted by parse_sdu_frame()
+    uint32_t invalid_frames;   // Rejected by parse_sdu_frame() or check_sdu_frame()
+    uint32_t queue_depth;      // Frames waiting in the scheduler now
+    uint32_t queue_high_water; // Most frames waiting at once
+    PaeHistogram tx_latency_ms; // Scheduler enqueue to TX_DONE
+} PaeFrameMetrics;
+
+// I/O sublayer
+typedef struct {
+    uint32_t reassembly_completed; // Segmented packets delivered
+    uint32_t reassembly_timeouts;  // Packets dropped by reassembly_expire()
+} PaeIoMetrics;
+
+typedef struct {
+    PaeFrameMetrics frame;
+    PaeIoMetrics io;
+} PaeMetrics;
+
+extern PaeMetrics pae_metrics;
+
+void pae_metrics_reset(void);
+
+// Pack the registry into `out`. Returns the length, or 0 if it does not fit in `capacity`
+// (PAE_METRICS_SNAPSHOT_MAX always fits).
+size_t pae_metrics_snapshot(uint8_t *out, size_t capacity);
+// Unpack a snapshot into `out`; false if it is truncated or of another version
+bool pae_metrics_parse(const uint8_t *data, size_t length, PaeMetrics *out);
+
+void pae_metrics_histogram_add(PaeHistogram *histogram, uint32_t value);
+
+// Hot-path updates
+
+static inline void pae_metrics_tx_frame(uint8_t PortID, size_t bytes) {
+#if PAE_METRICS_ENABLED
+    PaePortCounters *port = &pae_metrics.frame.tx[PortID & (NUM_PORTS - 1)];
+    port->frames++;
+    port->bytes += (uint32_t)bytes;
+#else
+    (void)PortID;
+    (void)bytes;
+#endif
+}
+
+static inline void pae_metrics_rx_frame(uint8_t PortID, size_t bytes) {
+#if PAE_METRICS_ENABLED
+    PaePortCounters *port = &pae_metrics.frame.rx[PortID & (NUM_PORTS - 1)];
+    port->frames++;
+    port->bytes += (uint32_t)bytes;
+#else
+    (void)PortID;
+    (void)bytes;
+#endif
+}
+
+static inline void pae_metrics_invalid_frame(void) {
+#if PAE_METRICS_ENABLED
+    pae_metrics.frame.invalid_frames++;
+#endif
+}
+
+static inline void pae_metrics_queue_depth(size_t depth) {
+#if PAE_METRICS_ENABLED
+    pae_metrics.frame.queue_depth = (uint32_t)depth;
+    if (depth > pae_metrics.frame.queue_high_water) {
+        pae_metrics.frame.queue_high_water = (uint32_t)depth;
+    }
+#else
+    (void)depth;
+#endif
+}
+
+static inline void pae_metrics_tx_latency(uint32_t latency_ms) {
+#if PAE_METRICS_ENABLED
+    pae_metrics_histogram_add(&pae_metrics.frame.tx_latency_ms, latency_ms);
+#else
+    (void)latency_ms;
+#endif
+}
+
+static inline void pae_metrics_reassembly_completed(void) {
+#if PAE_METRICS_ENABLED
+    pae_metrics.io.reassembly_completed++;
+#endif
+}
+
+static inline void pae_metrics_reassembly_timeouts(size_t expired) {
+#if PAE_METRICS_ENABLED
+    pae_metrics.io.reassembly_timeouts += (uint32_t)expired;
+#else
+    (void)expired;
+#endif
+}
+
+#endif // PAE_METRICS_H
@@ -0,0 +1,136 @@
+#include "pae_profile.h"
+
+#include <string.h>
+
+#if PAE_PROFILE_ENABLED
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total_ticks;
+    uint64_t total_bytes;
+    uint32_t buckets[PAE_PROFILE_BUCKETS];
+} PaeProbe;
+
+static PaeProbe probes[PAE_NUM_PROBES];
+
+static const char *const probe_names[PAE_NUM_PROBES] = {
+    [PAE_PROBE_SEGMENT_SDU] = "segment_sdu",
+    [PAE_PROBE_SERIALIZE_INTO] = "serialize_into",
+    [PAE_PROBE_DESERIALIZE_SDU_FRAME] = "deserialize_sdu_frame",
+    [PAE_PROBE_PARSE_SDU_FRAME] = "parse_sdu_frame",
+    [PAE_PROBE_SERIALIZE_TO_OBC] = "serialize_to_obc",
+    [PAE_PROBE_FEC_ENCODE] = "fec_encode",
+    [PAE_PROBE_FEC_DECODE] = "fec_decode",
+    [PAE_PROBE_CRC32] = "crc32_update",
+    [PAE_PROBE_COMPRESS_PACK] = "compress_pack",
+    [PAE_PROBE_COMPRESS_UNPACK] = "compress_unpack",
+};
+
+// Values below PAE_PROFILE_SUB_BUCKETS have their own bucket; above, the exponent picks the
+// octave and the next two bits the sub-bucket within it
+static size_t bucket_of(uint32_t ticks) {
+    if (ticks < PAE_PROFILE_SUB_BUCKETS) {
+        return ticks;
+    }
+    uint32_t exponent = 31u - (uint32_t)__builtin_clz(ticks); // >= 2
+    uint32_t sub = (ticks >> (exponent - 2)) & (PAE_PROFILE_SUB_BUCKETS - 1);
+    return (exponent - 1) * PAE_PROFILE_SUB_BUCKETS + sub;
+}
+
+static uint32_t bucket_upper_bound(size_t bucket) {
+    if (bucket < PAE_PROFILE_SUB_BUCKETS) {
+        return (uint32_t)bucket;
+    }
+    uint32_t exponent = (uint32_t)(bucket / PAE_PROFILE_SUB_BUCKETS) + 1;
+    uint64_t sub = bucket % PAE_PROFILE_SUB_BUCKETS;
+    uint64_t next = (PAE_PROFILE_SUB_BUCKETS + sub + 1) << (exponent - 2);
+    return (next > UINT32_MAX) ? UINT32_MAX : (uint32_t)(next - 1);
+}
+
+void pae_profile_reset(void) {
+    memset(probes, 0, sizeof(probes));
+}
+
+void pae_profile_record(PaeProbeId probe, uint32_t ticks, size_t bytes) {
+    if ((unsigned)probe >= PAE_NUM_PROBES) {
+        return;
+    }
+    PaeProbe *p = &probes[probe];
+    if (p->count == 0 || ticks < p->min) {
+        p->min = ticks;
+    }
+    if (ticks > p->max) {
+        p->max = ticks;
+    }
+    p->count++;
+    p->total_ticks += ticks;
+    p->total_bytes += bytes;
+    p->buckets[bucket_of(ticks)]++;
+}
+
+bool pae_profile_get(PaeProbeId probe, PaeProfileStats *out) {
+    if ((unsigned)probe >= PAE_NUM_PROBES || probes[probe].count == 0) {
+        return false;
+    }
+    const PaeProbe *p = &probes[probe];
+
+    // Smallest bucket with at least 99% of the measurements at or below it
+    uint64_t target = ((uint64_t)p->count * 99 + 99) / 100;
+    uint64_t seen = 0;
+    size_t bucket = 0;
+    for (; bucket < PAE_PROFILE_BUCKETS - 1; bucket++) {
+        seen += p->buckets[bucket];
+        if (seen >= target) {
+            break;
+        }
+    }
+    uint32_t p99 = bucket_upper_bound(bucket);
+
+    out->name = probe_names[probe];
+    out->count = p->count;
+    out->min = p->min;
+    out->mean = (uint32_t)(p->total_ticks / p->count);
+    out->max = p->max;
+    out->p99 = (p99 > p->max) ? p->max : p99;
+    out->ticks_per_byte_x100 = (p->total_bytes > 0) ? (uint32_t)(p->total_ticks * 100 / p->total_bytes) : 0;
+    return true;
+}
+
+void pae_profile_report(void (*print)(const char *fmt, ...)) {
+    print("Profile (%lu ticks/us): probe count min mean p99 max ticks/byte\n",
+        (unsigned long)pae_clock_ticks_per_us());
+    for (size_t i = 0; i < PAE_NUM_PROBES; i++) {
+        PaeProfileStats stats;
+        if (pae_profile_get((PaeProbeId)i, &stats)) {
+            print("  %s %lu %lu %lu %lu %lu %lu.%02lu\n", stats.name, (unsigned long)stats.count,
+                (unsigned long)stats.min, (unsigned long)stats.mean, (unsigned long)stats.p99,
+                (unsigned long)stats.max, (unsigned long)(stats.ticks_per_byte_x100 / 100),
+                (unsigned long)(stats.ticks_per_byte_x100 % 100));
+        }
+    }
+}
+
+#else
+
+void pae_profile_reset(void) {
+}
+
+void pae_profile_record(PaeProbeId probe, uint32_t ticks, size_t bytes) {
+    (void)probe;
+    (void)ticks;
+    (void)bytes;
+}
+
+bool pae_profile_get(PaeProbeId probe, PaeProfileStats *out) {
+    (void)probe;
+    (void)out;
+    return false;
+}
+
+void pae_profile_report(void (*print)(const char *fmt, ...)) {
+    (void)print;
+}
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef PAE_PROFILE_H
+#define PAE_PROFILE_H
+
+#include "pae_clock.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Hot-path profiling. A probe times the enclosing block with pae_clock_ticks() (DWT cycles
+// on the STM32L4, nanoseconds on the host) and keeps count, min, mean, max and a p99 taken
+// from a log-linear histogram, plus the bytes processed for the cost per byte.
+//
+//     size_t serialize_into(...) {
+//         PAE_PROFILE_SCOPE(PAE_PROBE_SERIALIZE_INTO); // Stops when the function returns
+//         ...
+//         PAE_PROFILE_BYTES(total_length);
+//
+// Build with -DPAE_PROFILE_ENABLED=1 to turn the probes on; by default they compile to
+// nothing and the probe storage is left out. Probes are not interrupt safe: time code
+// that runs from the main loop only. One PAE_PROFILE_SCOPE per block.
+#ifndef PAE_PROFILE_ENABLED
+#define PAE_PROFILE_ENABLED 0
+#endif
+
+typedef enum {
+    PAE_PROBE_SEGMENT_SDU,           // segment_sdu(), segment_sdu_pinned()
+    PAE_PROBE_SERIALIZE_INTO,        // serialize_into()
+    PAE_PROBE_DESERIALIZE_SDU_FRAME, // deserialize_sdu_frame()
+    PAE_PROBE_PARSE_SDU_FRAME,       // parse_sdu_frame()
+    PAE_PROBE_SERIALIZE_TO_OBC,      // serialize_to_obc()
+    PAE_PROBE_FEC_ENCODE,            // fec_encode()
+    PAE_PROBE_FEC_DECODE,            // fec_decode()
+    PAE_PROBE_CRC32,                 // crc32_update()
+    PAE_PROBE_COMPRESS_PACK,         // compress_pack(), bytes of payload in
+    PAE_PROBE_COMPRESS_UNPACK,       // compress_unpack() of an LZ block, bytes of payload out
+    PAE_NUM_PROBES
+} PaeProbeId;
+
+// Histogram: values 0..3 exactly, then 4 buckets per power of two (12.5% resolution)
+#define PAE_PROFILE_SUB_BUCKETS 4
+#define PAE_PROFILE_BUCKETS (31 * PAE_PROFILE_SUB_BUCKETS)
+
+typedef struct {
+    const char *name;
+    uint32_t count;
+    uint32_t min;                 // Ticks
+    uint32_t mean;
+    uint32_t max;
+    uint32_t p99;                 // Upper bound of the bucket holding the 99th percentile
+    uint32_t ticks_per_byte_x100; // Total ticks / total bytes, times 100 (0 if no bytes were reported)
+} PaeProfileStats;
+
+typedef struct {
+    uint8_t probe;
+    uint32_t start;
+    size_t bytes;
+} PaeProfileScope;
+
+void pae_profile_reset(void);
+// Add one measurement to `probe`
+void pae_profile_record(PaeProbeId probe, uint32_t ticks, size_t bytes);
+// False if profiling is disabled, the probe is unknown or it has no measurement yet
+bool pae_profile_get(PaeProbeId probe, PaeProfileStats *out);
+// Print one line per probe that ran, e.g. with hal_mcu_trace_print()
+void pae_profile_report(void (*print)(const char *fmt, ...));
+
+static inline PaeProfileScope pae_profile_begin(PaeProbeId probe) {
+    PaeProfileScope scope = {(uint8_t)probe, pae_clock_ticks(), 0};
+    return scope;
+}
+
+// Cleanup handler of PAE_PROFILE_SCOPE
+static inline void pae_profile_end(PaeProfileScope *scope) {
+    pae_profile_record((PaeProbeId)scope->probe, pae_clock_ticks() - scope->start, scope->bytes);
+}
+
+#if PAE_PROFILE_ENABLED
+#define PAE_PROFILE_SCOPE(probe) \
+    PaeProfileScope pae_profile_scope_ __attribute__((cleanup(pae_profile_end))) = pae_profile_begin(probe)
+#define PAE_PROFILE_BYTES(count) (pae_profile_scope_.bytes = (size_t)(count))
+#else
+#define PAE_PROFILE_SCOPE(probe) ((void)0)
+#define PAE_PROFILE_BYTES(count) ((void)0)
+#endif
+
+#endif // PAE_PROFILE_H
@@ -0,0 +1,13 @@
+#include "pdu_codec.h"
+
+void pdu_header_encode_batch(const PDUHeader *headers, size_t count, uint8_t *out) {
+    for (size_t i = 0; i < count; i++) {
+        pdu_header_encode(&headers[i], out + i * SIZE_PDU_HEADER);
+    }
+}
+
+void pdu_header_decode_batch(const uint8_t *in, size_t count, PDUHeader *headers) {
+    for (size_t i = 0; i < count; i++) {
+        pdu_header_decode(in + i * SIZE_PDU_HEADER, &headers[i]);
+    }
+}
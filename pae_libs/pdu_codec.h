@@ -0,0 +1,98 @@
+#ifndef PDU_CODEC_H
+#define PDU_CODEC_H
+
+#include "protocol_definitions.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// Explicit wire codec for the PDU and segmentation headers.
+// The on-air layout is fixed by the shifts and masks below, so encoding no longer depends
+// on how the compiler lays out the bitfields in PDUHeader (which differs on big-endian hosts).
+// All the single-header functions are straight-line code: no branches, no table lookups.
+
+// Byte 0: [SC_ID 9-8 | DFC_ID | PDU_ID | QoS | Version]
+#define PDU_VERSION_SHIFT 0
+#define PDU_VERSION_MASK 0x03
+#define PDU_QOS_SHIFT 2
+#define PDU_QOS_MASK 0x01
+#define PDU_PDU_ID_SHIFT 3
+#define PDU_PDU_ID_MASK 0x01
+#define PDU_DFC_ID_SHIFT 4
+#define PDU_DFC_ID_MASK 0x03
+#define PDU_SC_ID_HIGH_SHIFT 6
+#define PDU_SC_ID_HIGH_MASK 0x03
+// Byte 1: SC_ID 7-0
+// Byte 2: [data length 10-8 | SD_ID | PortID | PC_ID]
+#define PDU_PC_ID_SHIFT 0
+#define PDU_PC_ID_MASK 0x01
+#define PDU_PORT_ID_SHIFT 1
+#define PDU_PORT_ID_MASK 0x07
+#define PDU_SD_ID_SHIFT 4
+#define PDU_SD_ID_MASK 0x01
+#define PDU_LENGTH_HIGH_SHIFT 5
+#define PDU_LENGTH_HIGH_MASK 0x07
+// Byte 3: data length 7-0
+// Byte 4: FSN
+
+// Segmentation header: [PseudoPacketID | SegFlag]
+#define SEG_FLAG_SHIFT 0
+#define SEG_FLAG_MASK 0x03
+#define SEG_PSEUDO_ID_SHIFT 2
+#define SEG_PSEUDO_ID_MASK 0x3F
+
+#define PDU_FIELD(value, name) ((uint8_t)(((value) & PDU_##name##_MASK) << PDU_##name##_SHIFT))
+#define PDU_GET(byte, name) (((byte) >> PDU_##name##_SHIFT) & PDU_##name##_MASK)
+
+// Write SIZE_PDU_HEADER bytes to `out`
+static inline void pdu_header_encode(const PDUHeader *header, uint8_t *out) {
+    out[0] = PDU_FIELD(header->VersionNum, VERSION) | PDU_FIELD(header->QoS, QOS) |
+             PDU_FIELD(header->PDU_ID, PDU_ID) | PDU_FIELD(header->DFC_ID, DFC_ID) |
+             PDU_FIELD(header->SC_ID_part1, SC_ID_HIGH);
+    out[1] = header->SC_ID_part2;
+    out[2] = PDU_FIELD(header->PC_ID, PC_ID) | PDU_FIELD(header->PortID, PORT_ID) |
+             PDU_FIELD(header->SD_ID, SD_ID) | PDU_FIELD(header->data_length_high, LENGTH_HIGH);
+    out[3] = header->data_length_low;
+    out[4] = header->FSN;
+}
+
+// Read SIZE_PDU_HEADER bytes from `in`
+static inline void pdu_header_decode(const uint8_t *in, PDUHeader *header) {
+    header->VersionNum = PDU_GET(in[0], VERSION);
+    header->QoS = PDU_GET(in[0], QOS);
+    header->PDU_ID = PDU_GET(in[0], PDU_ID);
+    header->DFC_ID = PDU_GET(in[0], DFC_ID);
+    header->SC_ID_part1 = PDU_GET(in[0], SC_ID_HIGH);
+    header->SC_ID_part2 = in[1];
+    header->PC_ID = PDU_GET(in[2], PC_ID);
+    header->PortID = PDU_GET(in[2], PORT_ID);
+    header->SD_ID = PDU_GET(in[2], SD_ID);
+    header->data_length_high = PDU_GET(in[2], LENGTH_HIGH);
+    header->data_length_low = in[3];
+    header->FSN = in[4];
+}
+
+static inline uint8_t seg_header_encode(const SegmentationHeader *header) {
+    return (uint8_t)(((header->SegFlag & SEG_FLAG_MASK) << SEG_FLAG_SHIFT) |
+                     ((header->PseudoPacketID & SEG_PSEUDO_ID_MASK) << SEG_PSEUDO_ID_SHIFT));
+}
+
+static inline void seg_header_decode(uint8_t in, SegmentationHeader *header) {
+    header->SegFlag = (in >> SEG_FLAG_SHIFT) & SEG_FLAG_MASK;
+    header->PseudoPacketID = (in >> SEG_PSEUDO_ID_SHIFT) & SEG_PSEUDO_ID_MASK;
+}
+
+// Helpers on the decoded header
+static inline uint16_t pdu_header_data_length(const PDUHeader *header) {
+    return (uint16_t)(((uint16_t)header->data_length_high << 8) | header->data_length_low);
+}
+
+static inline uint16_t pdu_header_sc_id(const PDUHeader *header) {
+    return (uint16_t)(((uint16_t)header->SC_ID_part1 << 8) | header->SC_ID_part2);
+}
+
+// Batch variants: `count` headers packed back to back, SIZE_PDU_HEADER bytes each.
+// Used by the ground tools to decode captured header streams.
+void pdu_header_encode_batch(const PDUHeader *headers, size_t count, uint8_t *out);
+void pdu_header_decode_batch(const uint8_t *in, size_t count, PDUHeader *headers);
+
+#endif // PDU_CODEC_H
@@ -5,9 +5,30 @@
 #include <stdbool.h>
 
 // Fundamental constants
-#define MAX_UNFRAGMENTED_SDU_SIZE 250 //5pdu HEADER
-#define MAX_FRAGMENTED_SDU_SIZE 249 //1 Fragamentation HEADER
 #define MAX_TOTAL_FRAME_SIZE 255
+
+// Frame check sequence: CRC-32 trailer after the SDU (-DFCS_ENABLED=0 to disable)
+#ifndef FCS_ENABLED
+#define FCS_ENABLED 1
+#endif
+#if FCS_ENABLED
+#define SIZE_FCS 4 // CRC-32 trailer size (4 bytes)
+#else
+#define SIZE_FCS 0
+#endif
+
+// Forward error correction: Reed-Solomon parity bytes added to each LoRa packet (see fec.h).
+// 32 gives RS(255,223); must be even, 0 disables the FEC stage.
+#ifndef FEC_PARITY
+#define FEC_PARITY 32
+#endif
+#if FEC_PARITY % 2 != 0 || FEC_PARITY > 64
+#error "FEC_PARITY must be even and no larger than 64"
+#endif
+
+#define MAX_CODED_FRAME_SIZE (MAX_TOTAL_FRAME_SIZE - FEC_PARITY) // Serialized frame before FEC
+#define MAX_UNFRAGMENTED_SDU_SIZE (MAX_CODED_FRAME_SIZE - SIZE_PDU_HEADER - SIZE_FCS) //5pdu HEADER
+#define MAX_FRAGMENTED_SDU_SIZE (MAX_UNFRAGMENTED_SDU_SIZE - SIZE_SEGMENTATION_HEADER) //1 Fragamentation HEADER
 #define VERSION_3 0b10 // Version 3 of Proximity-1
 #define EXPEDITED 1 // Expedited QoS mode
 #define SEQUENCED_CONTROLLEED 0 // Sequenced Controlled QoS mode
@@ -17,8 +38,10 @@
 #define DFC_FRAGMENTED 0b01 // a complete or segmented packet (2 bits)
 #define DFC_CCSDS 0b10 // Reserved for future CCSDS definitions (2 bits)
 #define DFC_RESERVED 0b11 // Reserved for future user definitions (2 bits)
+#define DFC_AGGREGATED DFC_RESERVED // User definition: several length-prefixed unsegmented packets
 #define SIZE_PDU_HEADER 5 // PDU header size (5 bytes)
 #define SIZE_SEGMENTATION_HEADER 1 // Segmentation header size (1 byte)
+#define SIZE_AGGREGATION_LENGTH 1 // Length prefix of each packet in an aggregated SDU (1 byte)
 #define PDU_DATA 0x00 // Data PDU ID (1 byte)
 #define PDU_COMMAND 0x01 // Command PDU ID (protocol/supervisory data) (1 byte)
 
@@ -28,7 +51,7 @@ typedef enum {
     FRAME_FRAGMENTED = 1
 } FrameType;
 
-// Structure for the PDU header (bitfields ordered for little-endian ARM memcpy compatibility)
+// Structure for the PDU header (decoded view; the wire format is written by pdu_codec.h)
 typedef struct __attribute__((packed)) {
     // Byte 0: [bits 7-0] = [SC_ID₁₋₂|DFC_ID|PDU_ID|QoS|Ver]
     uint8_t VersionNum : 2;   // Proximity-1 Version [bits 0-1]
@@ -53,7 +76,9 @@ typedef struct __attribute__((packed)) {
     uint8_t FSN : 8;          // Frame Sequence Number [bits 0-7]
 } PDUHeader;
 
-// Structure for the segmentation header (bitfields ordered for little-endian)
+#define NUM_PORTS 8 // PortID is 3 bits: size of every per-port table
+
+// Structure for the segmentation header (decoded view; see pdu_codec.h)
 typedef struct __attribute__((packed)) {
     uint8_t SegFlag : 2;      // Segmentation Flag [bits 0-1]
     uint8_t PseudoPacketID : 6; // Pseudo Packet ID [bits 2-7]
@@ -62,7 +87,7 @@ typedef struct __attribute__((packed)) {
 // Structure for the SDU
 // Structure representing a Service Data Unit (SDU) Frame, which can be either unfragmented or fragmented
 typedef struct SDUFrame {
-    FrameType type; // Indicates if the frame is unfragmented or fragmented
+    uint8_t type; // FrameType: indicates if the frame is unfragmented or fragmented
 
     union {
         // Structure for unfragmented SDU frames
@@ -78,8 +103,6 @@ typedef struct SDUFrame {
             uint8_t *sdu;                // Pointer to the SDU data fragment
         } fragmented;
     } data;
-
-    struct SDUFrame *next; // Pointer to the next SDUFrame in a linked list (for chaining frames)
 } SDUFrame;
 
 typedef struct {
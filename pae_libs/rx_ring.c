@@ -0,0 +1,55 @@
+#include "rx_ring.h"
+
+#include <string.h>
+
+#define RX_RING_MASK (RX_RING_DEPTH - 1)
+
+// The index store is a release: the entry contents are visible before the new index.
+// The index load is an acquire: the entry is read only after the index that published it.
+static inline void rx_ring_publish(volatile uint8_t *index, uint8_t value) {
+    __atomic_store_n(index, value, __ATOMIC_RELEASE);
+}
+
+static inline uint8_t rx_ring_observe(const volatile uint8_t *index) {
+    return __atomic_load_n(index, __ATOMIC_ACQUIRE);
+}
+
+void rx_ring_init(RxRing *ring) {
+    memset(ring, 0, sizeof(RxRing));
+}
+
+size_t rx_ring_count(const RxRing *ring) {
+    return (uint8_t)(rx_ring_observe(&ring->head) - rx_ring_observe(&ring->tail));
+}
+
+RxRingEntry *rx_ring_reserve(RxRing *ring) {
+    uint8_t head = ring->head;
+    if ((uint8_t)(head - rx_ring_observe(&ring->tail)) == RX_RING_DEPTH) {
+        ring->dropped++;
+        return NULL;
+    }
+    return &ring->entries[head & RX_RING_MASK];
+}
+
+void rx_ring_commit(RxRing *ring) {
+    uint8_t head = (uint8_t)(ring->head + 1);
+    rx_ring_publish(&ring->head, head);
+    ring->received++;
+
+    uint8_t waiting = (uint8_t)(head - rx_ring_observe(&ring->tail));
+    if (waiting > ring->high_water) {
+        ring->high_water = waiting;
+    }
+}
+
+RxRingEntry *rx_ring_peek(RxRing *ring) {
+    uint8_t tail = ring->tail;
+    if (rx_ring_observe(&ring->head) == tail) {
+        return NULL;
+    }
+    return &ring->entries[tail & RX_RING_MASK];
+}
+
+void rx_ring_release(RxRing *ring) {
+    rx_ring_publish(&ring->tail, (uint8_t)(ring->tail + 1));
+}
@@ -0,0 +1,54 @@
+#ifndef RX_RING_H
+#define RX_RING_H
+
+#include "protocol_definitions.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Lock-free single-producer / single-consumer ring of received LoRa packets.
+// The producer copies each packet and its link quality out of the radio into the next free
+// entry; the consumer decodes entries in order and releases them. Only the producer writes
+// `head` and only the consumer writes `tail`, so no lock is needed: in RX_PROXIMITY the
+// producer is the radio DIO interrupt, so a frame is out of the LR11xx's single RX buffer
+// before the next one lands, however long the main loop takes to decode the previous one.
+#ifndef RX_RING_DEPTH
+#define RX_RING_DEPTH 8 // Packets buffered while the main loop is busy, must be a power of two
+#endif
+
+#if (RX_RING_DEPTH & (RX_RING_DEPTH - 1)) != 0 || RX_RING_DEPTH > 128
+#error "RX_RING_DEPTH must be a power of two no larger than 128"
+#endif
+
+typedef struct {
+    uint8_t data[MAX_TOTAL_FRAME_SIZE]; // LoRa payload as received (frame + FEC parity)
+    uint8_t length;
+    int8_t rssi_dbm;
+    int8_t snr_db;
+    uint32_t received_ticks; // pae_clock_ticks() at RX_DONE (see pae_clock_ms_at())
+} RxRingEntry;
+
+typedef struct {
+    RxRingEntry entries[RX_RING_DEPTH];
+    volatile uint8_t head;       // Next entry to fill (producer)
+    volatile uint8_t tail;       // Next entry to consume (consumer)
+    volatile uint32_t received;  // Packets committed
+    volatile uint32_t dropped;   // Packets lost because the ring was full
+    volatile uint8_t high_water; // Most entries waiting at once
+} RxRing;
+
+void rx_ring_init(RxRing *ring);
+
+// Producer side. Reserve the next free entry (NULL and a drop counted if the ring is full),
+// fill it, then publish it with rx_ring_commit().
+RxRingEntry *rx_ring_reserve(RxRing *ring);
+void rx_ring_commit(RxRing *ring);
+
+// Consumer side. The oldest entry, or NULL if the ring is empty. The entry stays valid and
+// may be modified in place (FEC correction, parsing) until rx_ring_release().
+RxRingEntry *rx_ring_peek(RxRing *ring);
+void rx_ring_release(RxRing *ring);
+
+size_t rx_ring_count(const RxRing *ring);
+
+#endif // RX_RING_H
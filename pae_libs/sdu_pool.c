@@ -0,0 +1,70 @@
+#include "sdu_pool.h"
+#include <stdio.h>
+
+#if SDU_POOL_BLOCKS > 0xFFFF
+#error "SDU_POOL_BLOCKS must fit in 16 bits"
+#endif
+
+#define POOL_END 0xFFFF // End of the free list
+
+static uint8_t pool_storage[SDU_POOL_BLOCKS][SDU_POOL_BLOCK_SIZE];
+static uint16_t pool_next_free[SDU_POOL_BLOCKS]; // Free list links, one per block
+static uint16_t pool_free_head = POOL_END;
+static bool pool_initialized = false;
+static SDUPoolStats pool_stats = {0};
+
+// Chain every block in the free list (done lazily on first use)
+static void sdu_pool_init(void) {
+    for (uint16_t i = 0; i < SDU_POOL_BLOCKS; i++) {
+        pool_next_free[i] = (i + 1 < SDU_POOL_BLOCKS) ? (uint16_t)(i + 1) : POOL_END;
+    }
+    pool_free_head = (SDU_POOL_BLOCKS > 0) ? 0 : POOL_END;
+    pool_initialized = true;
+}
+
+uint8_t* sdu_pool_alloc(size_t size) {
+    if (!pool_initialized) {
+        sdu_pool_init();
+    }
+    if (size > SDU_POOL_BLOCK_SIZE || pool_free_head == POOL_END) {
+        pool_stats.failed_allocs++;
+        return NULL;
+    }
+
+    uint16_t block = pool_free_head;
+    pool_free_head = pool_next_free[block];
+
+    pool_stats.in_use++;
+    pool_stats.total_allocs++;
+    if (pool_stats.in_use > pool_stats.high_water) {
+        pool_stats.high_water = pool_stats.in_use;
+    }
+    return pool_storage[block];
+}
+
+void sdu_pool_free(uint8_t *block) {
+    if (block == NULL) {
+        return;
+    }
+    if (!sdu_pool_owns(block)) {
+        fprintf(stderr, "Error: Pointer does not belong to the SDU pool.\n");
+        return;
+    }
+
+    uint16_t index = (uint16_t)((block - &pool_storage[0][0]) / SDU_POOL_BLOCK_SIZE);
+    pool_next_free[index] = pool_free_head;
+    pool_free_head = index;
+    pool_stats.in_use--;
+}
+
+bool sdu_pool_owns(const uint8_t *ptr) {
+    const uint8_t *base = &pool_storage[0][0];
+    if (ptr < base || ptr >= base + sizeof(pool_storage)) {
+        return false;
+    }
+    return ((size_t)(ptr - base) % SDU_POOL_BLOCK_SIZE) == 0;
+}
+
+SDUPoolStats sdu_pool_get_stats(void) {
+    return pool_stats;
+}
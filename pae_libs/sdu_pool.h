@@ -0,0 +1,38 @@
+#ifndef SDU_POOL_H
+#define SDU_POOL_H
+
+#include "protocol_definitions.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+// Fixed-block allocator for SDU payloads and serialized frames.
+// Every block holds one full frame, so any payload of the protocol fits in one block.
+// The number of blocks is fixed at build time (-DSDU_POOL_BLOCKS=n). The copying segment_sdu()
+// takes one block per segment, so the default holds one full packet of 255 segments
+// (IO_BUFFER_MAX_FRAMES; io_sublayer.c refuses to build with fewer). Builds that only use
+// the pinned or streaming segmentation can shrink both.
+#ifndef SDU_POOL_BLOCKS
+#define SDU_POOL_BLOCKS 255
+#endif
+#define SDU_POOL_BLOCK_SIZE MAX_TOTAL_FRAME_SIZE
+
+typedef struct {
+    uint32_t in_use;        // Blocks currently allocated
+    uint32_t high_water;    // Maximum number of blocks allocated at the same time
+    uint32_t failed_allocs; // Allocations refused (pool exhausted or size too large)
+    uint32_t total_allocs;  // Successful allocations since start-up
+} SDUPoolStats;
+
+// Allocate one block able to hold `size` bytes. O(1). Returns NULL on failure.
+uint8_t* sdu_pool_alloc(size_t size);
+
+// Return a block to the pool. O(1). NULL is ignored.
+void sdu_pool_free(uint8_t *block);
+
+// True if `ptr` points to the start of a pool block
+bool sdu_pool_owns(const uint8_t *ptr);
+
+SDUPoolStats sdu_pool_get_stats(void);
+
+#endif // SDU_POOL_H
@@ -0,0 +1,93 @@
+// Compression ratio against cost: packs and unpacks a few typical payloads and prints the
+// envelope size and the pae_clock_ticks() per payload byte (nanoseconds on the host).
+// Usage: make -C pae_libs/tests bench
+#include "compress.h"
+#include "pae_clock.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_ROUNDS 1000
+
+static uint8_t packed[COMPRESS_MAX_PACKET_SIZE + SIZE_COMPRESS_ENVELOPE];
+static uint8_t expanded[COMPRESS_MAX_PACKET_SIZE];
+
+// Deterministic noise, so runs compare
+static uint32_t bench_seed = 3;
+static uint8_t bench_random(void) {
+    bench_seed = bench_seed * 1103515245u + 12345u;
+    return (uint8_t)(bench_seed >> 16);
+}
+
+static int bench(const char *name, const uint8_t *payload, size_t length) {
+    size_t packed_length = 0;
+    uint32_t start = pae_clock_ticks();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        packed_length = compress_pack(payload, length, packed, sizeof(packed));
+    }
+    uint32_t pack_ticks = pae_clock_ticks() - start;
+
+    size_t expanded_length = 0;
+    const uint8_t *out = NULL;
+    start = pae_clock_ticks();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        out = compress_unpack(packed, packed_length, expanded, sizeof(expanded), &expanded_length);
+    }
+    uint32_t unpack_ticks = pae_clock_ticks() - start;
+
+    if (out == NULL || expanded_length != length || memcmp(out, payload, length) != 0) {
+        fprintf(stderr, "Error: %s does not round-trip.\n", name);
+        return 1;
+    }
+    printf("%-18s %5zu -> %5zu bytes (%3zu%%) %-4s pack %6.2f ticks/B  unpack %6.2f ticks/B\n",
+        name, length, packed_length, packed_length * 100 / length, packed[0] == COMPRESS_LZ ? "lz" : "raw",
+        (double)pack_ticks / BENCH_ROUNDS / length, (double)unpack_ticks / BENCH_ROUNDS / length);
+    return 0;
+}
+
+int main(void) {
+    pae_clock_init();
+    int failures = 0;
+
+    // The TX_PROXIMITY example payload: three runs of one letter behind a short header
+    static uint8_t example[3 * 110];
+    for (size_t i = 0; i < 3; i++) {
+        int header = snprintf((char *)&example[i * 110], 110, "Este es el packete %d con rellenos de %c: ",
+            (int)i + 1, 'A' + (int)i);
+        memset(&example[i * 110 + header], 'A' + (int)i, 110 - header);
+    }
+    failures += bench("example payload", example, sizeof(example));
+
+    // Telemetry: 64 records of 24 bytes, timestamp, id and slowly varying 16-bit readings
+    static uint8_t telemetry[64 * 24];
+    for (size_t r = 0; r < 64; r++) {
+        uint8_t *record = &telemetry[r * 24];
+        uint32_t timestamp = 1700000000u + (uint32_t)r * 10;
+        memcpy(record, &timestamp, sizeof(timestamp));
+        record[4] = 0xA5;
+        record[5] = (uint8_t)r;
+        for (size_t j = 6; j < 24; j += 2) {
+            uint16_t reading = (uint16_t)(1000 + j * 10 + bench_random() % 3);
+            memcpy(&record[j], &reading, sizeof(reading));
+        }
+    }
+    failures += bench("telemetry 64x24B", telemetry, sizeof(telemetry));
+
+    // Log text
+    static char log[COMPRESS_MAX_PACKET_SIZE];
+    size_t log_length = 0;
+    for (int i = 0; log_length < 2000; i++) {
+        log_length += (size_t)snprintf(&log[log_length], sizeof(log) - log_length,
+            "[%06d] INFO  eps: bus=%d.%02dV batt=%d%% mode=NOMINAL\n", i * 250, 3 + i % 2, bench_random() % 100, 80 - i % 5);
+    }
+    failures += bench("log lines", (const uint8_t *)log, log_length);
+
+    // Incompressible: goes out raw with the one-byte envelope
+    static uint8_t noise[1024];
+    for (size_t i = 0; i < sizeof(noise); i++) {
+        noise[i] = bench_random();
+    }
+    failures += bench("random", noise, sizeof(noise));
+
+    return failures;
+}
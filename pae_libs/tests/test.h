@@ -0,0 +1,20 @@
+#ifndef PAE_TEST_H
+#define PAE_TEST_H
+
+#include <stdio.h>
+
+// Minimal host test support: CHECK() reports the failing condition and carries on, the
+// test's main() returns TEST_RESULT() so make stops on the first failing program.
+static int test_failures;
+
+#define CHECK(cond)                                                                    \
+    do {                                                                               \
+        if (!(cond)) {                                                                 \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);   \
+            test_failures++;                                                           \
+        }                                                                              \
+    } while (0)
+
+#define TEST_RESULT() (test_failures == 0 ? 0 : 1)
+
+#endif // PAE_TEST_H
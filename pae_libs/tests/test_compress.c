@@ -0,0 +1,88 @@
+#include "test.h"
+#include "compress.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static uint8_t packed[COMPRESS_MAX_PACKET_SIZE + 64];
+static uint8_t expanded[COMPRESS_MAX_PACKET_SIZE];
+
+// Random data with repeats copied from up to 300 bytes back, so blocks mix literals and matches
+static void fill(uint8_t *data, size_t length, int alphabet) {
+    for (size_t i = 0; i < length; i++) {
+        if (i > 8 && rand() % 3 == 0) {
+            size_t offset = 1 + (size_t)rand() % (i < 300 ? i : 300);
+            data[i] = data[i - offset];
+        } else {
+            data[i] = (uint8_t)(rand() % alphabet);
+        }
+    }
+}
+
+static void test_round_trip(void) {
+    static uint8_t data[3000];
+    for (int trial = 0; trial < 2000; trial++) {
+        size_t length = 1 + (size_t)rand() % sizeof(data);
+        fill(data, length, 1 + rand() % 256);
+
+        size_t block = lz_compress(data, length, packed, sizeof(packed));
+        CHECK(block > 0);
+        CHECK(lz_decompress(packed, block, expanded, length) == length);
+        CHECK(memcmp(expanded, data, length) == 0);
+
+        // Too small an output fails cleanly
+        CHECK(lz_decompress(packed, block, expanded, length - 1) == 0);
+        size_t capacity = (size_t)rand() % (block + 1);
+        CHECK(lz_compress(data, length, packed, capacity) <= capacity);
+    }
+}
+
+// Corrupted blocks are rejected or expanded within bounds, never read or written past them
+static void test_malformed(void) {
+    static uint8_t data[1024];
+    for (int trial = 0; trial < 2000; trial++) {
+        size_t length = 1 + (size_t)rand() % sizeof(data);
+        fill(data, length, 16);
+        size_t block = lz_compress(data, length, packed, sizeof(packed));
+        for (size_t i = 0; i < block; i++) {
+            packed[i] ^= (uint8_t)rand();
+        }
+        CHECK(lz_decompress(packed, block, expanded, length) <= length);
+    }
+}
+
+static void test_envelope(void) {
+    static uint8_t text[1000];
+    static uint8_t noise[256];
+    memset(text, 'A', sizeof(text));
+    for (size_t i = 0; i < sizeof(noise); i++) {
+        noise[i] = (uint8_t)rand();
+    }
+    size_t payload_length = 0;
+
+    // Compressible: sent as an LZ block, smaller than the payload
+    size_t length = compress_pack(text, sizeof(text), packed, sizeof(packed));
+    CHECK(length > 0 && length < sizeof(text));
+    CHECK(packed[0] == COMPRESS_LZ);
+    const uint8_t *payload = compress_unpack(packed, length, expanded, sizeof(expanded), &payload_length);
+    CHECK(payload != NULL && payload_length == sizeof(text) && memcmp(payload, text, sizeof(text)) == 0);
+
+    // Incompressible: sent raw with one byte of envelope
+    length = compress_pack(noise, sizeof(noise), packed, sizeof(packed));
+    CHECK(length == sizeof(noise) + SIZE_COMPRESS_ENVELOPE);
+    CHECK(packed[0] == COMPRESS_NONE);
+    payload = compress_unpack(packed, length, expanded, sizeof(expanded), &payload_length);
+    CHECK(payload != NULL && payload_length == sizeof(noise) && memcmp(payload, noise, sizeof(noise)) == 0);
+
+    // Unknown envelope
+    packed[0] = 0x7F;
+    CHECK(compress_unpack(packed, length, expanded, sizeof(expanded), &payload_length) == NULL);
+}
+
+int main(void) {
+    srand(3);
+    test_round_trip();
+    test_malformed();
+    test_envelope();
+    return TEST_RESULT();
+}
@@ -0,0 +1,44 @@
+#include "test.h"
+#include "crc32.h"
+
+#include <string.h>
+
+// Bit-at-a-time reference of the same parameter set
+static uint32_t crc32_bitwise(const uint8_t *data, size_t len) {
+    uint32_t crc = CRC32_INIT;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint32_t)data[i] << 24;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80000000u) ? (crc << 1) ^ CRC32_POLY : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+// The check value pins the parameter set of the frame check sequence
+static void test_check_value(void) {
+    const uint8_t check[] = "123456789";
+    CHECK(crc32_compute(check, 9) == 0x51693C0Cu);
+    CHECK(crc32_self_test());
+}
+
+// Every length and start offset matches the reference, so the 8-byte (or word) loop and
+// the byte tail agree on unaligned data
+static void test_lengths_and_alignment(void) {
+    uint8_t data[64 + 8];
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)(i * 37 + 11);
+    }
+    for (size_t offset = 0; offset < 8; offset++) {
+        for (size_t len = 0; len <= 64; len++) {
+            CHECK(crc32_compute(data + offset, len) == crc32_bitwise(data + offset, len));
+        }
+    }
+}
+
+int main(void) {
+    crc32_init();
+    test_check_value();
+    test_lengths_and_alignment();
+    return TEST_RESULT();
+}
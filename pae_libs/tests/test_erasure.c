@@ -0,0 +1,144 @@
+#include "test.h"
+#include "io_sublayer.h"
+#include "frame_sublayer.h"
+#include "sdu_pool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_SEGMENTS 255
+
+typedef struct {
+    uint8_t data[MAX_TOTAL_FRAME_SIZE];
+    size_t length;
+} WireFrame;
+
+static WireFrame wire[MAX_SEGMENTS];
+
+// Code the packet on port 2 and serialize every segment, as they would go on air
+static size_t encode(const uint8_t *packet, size_t length, uint8_t overhead, size_t *k) {
+    erasure_set_port_overhead(2, overhead);
+    ErasureIterator it;
+    if (!erasure_iterator_init(&it, packet, length, 2, 1, 0x123, 0)) {
+        return 0;
+    }
+    size_t n = 0;
+    SDUFrame frame;
+    while (n < MAX_SEGMENTS && erasure_iterator_next(&it, &frame)) {
+        SerializedData serialized = serialize_sdu_frame(&frame);
+        memcpy(wire[n].data, serialized.data, serialized.length);
+        wire[n].length = serialized.length;
+        sdu_pool_free(serialized.data);
+        n++;
+    }
+    *k = it.k;
+    return n;
+}
+
+static ReassemblyStatus push(ErasureDecoder *decoder, size_t segment, uint32_t now_ms, SerializedData *out) {
+    SDUFrame frame;
+    if (!parse_sdu_frame(wire[segment].data, wire[segment].length, &frame)) {
+        return REASSEMBLY_ERROR;
+    }
+    return erasure_push(decoder, &frame, now_ms, out);
+}
+
+// Any k of the n segments rebuild the packet, whichever ones were lost
+static void test_recovery(void) {
+    static ErasureDecoder decoder;
+    static uint8_t packet[1000];
+    static const uint8_t overheads[] = {25, 50, 100};
+    srand(7);
+    for (size_t i = 0; i < sizeof(packet); i++) {
+        packet[i] = (uint8_t)rand();
+    }
+
+    for (size_t o = 0; o < sizeof(overheads); o++) {
+        for (int trial = 0; trial < 20; trial++) {
+            size_t k = 0;
+            size_t n = encode(packet, sizeof(packet), overheads[o], &k);
+            CHECK(n > k);
+
+            // Shuffle the segments and lose the first n - k of them
+            size_t order[MAX_SEGMENTS];
+            for (size_t i = 0; i < n; i++) {
+                order[i] = i;
+            }
+            for (size_t i = n - 1; i > 0; i--) {
+                size_t j = (size_t)rand() % (i + 1);
+                size_t swap = order[i];
+                order[i] = order[j];
+                order[j] = swap;
+            }
+
+            erasure_decoder_init(&decoder);
+            SerializedData out = {0};
+            for (size_t i = n - k; i < n - 1; i++) {
+                CHECK(push(&decoder, order[i], 0, &out) == REASSEMBLY_IN_PROGRESS);
+            }
+            CHECK(push(&decoder, order[n - 1], 0, &out) == REASSEMBLY_COMPLETE);
+            CHECK(out.length == sizeof(packet) && memcmp(out.data, packet, sizeof(packet)) == 0);
+
+            // A segment arriving after delivery is surplus
+            CHECK(push(&decoder, order[0], 0, &out) == REASSEMBLY_DUPLICATE);
+        }
+    }
+}
+
+// An incomplete packet is dropped after REASSEMBLY_TIMEOUT_MS without segments
+static void test_expire(void) {
+    static ErasureDecoder decoder;
+    static uint8_t packet[600];
+    memset(packet, 0x5A, sizeof(packet));
+    size_t k = 0;
+    size_t n = encode(packet, sizeof(packet), 50, &k);
+    CHECK(k > 1 && n > k);
+
+    erasure_decoder_init(&decoder);
+    SerializedData out = {0};
+    CHECK(push(&decoder, 0, 1000, &out) == REASSEMBLY_IN_PROGRESS);
+    CHECK(erasure_expire(&decoder, 1000 + REASSEMBLY_TIMEOUT_MS - 1) == 0);
+    CHECK(decoder.in_use);
+    CHECK(erasure_expire(&decoder, 1000 + REASSEMBLY_TIMEOUT_MS) == 1);
+    CHECK(!decoder.in_use);
+    CHECK(decoder.timeouts == 1);
+    CHECK(erasure_expire(&decoder, 1000 + 2 * REASSEMBLY_TIMEOUT_MS) == 0);
+
+    // A delivered packet is released without counting a timeout
+    for (size_t i = 0; i < k; i++) {
+        push(&decoder, i, 5000, &out);
+    }
+    CHECK(decoder.complete);
+    CHECK(erasure_expire(&decoder, 5000 + REASSEMBLY_TIMEOUT_MS) == 0);
+    CHECK(!decoder.in_use);
+    CHECK(decoder.timeouts == 1);
+}
+
+// The sender codes packets up to ERASURE_MAX_PACKET_SIZE, the most the decoder rebuilds
+static void test_size_limit(void) {
+    static ErasureDecoder decoder;
+    static uint8_t packet[ERASURE_MAX_PACKET_SIZE + 1];
+    for (size_t i = 0; i < sizeof(packet); i++) {
+        packet[i] = (uint8_t)(i * 13);
+    }
+    size_t k = 0;
+    CHECK(encode(packet, sizeof(packet), 25, &k) == 0);
+
+    size_t n = encode(packet, ERASURE_MAX_PACKET_SIZE, 25, &k);
+    CHECK(k == ERASURE_MAX_DATA_SEGMENTS && n > k);
+    erasure_decoder_init(&decoder);
+    SerializedData out = {0};
+    ReassemblyStatus status = REASSEMBLY_IN_PROGRESS;
+    for (size_t i = n - k; i < n; i++) {
+        status = push(&decoder, i, 0, &out); // Repair segments first
+    }
+    CHECK(status == REASSEMBLY_COMPLETE);
+    CHECK(out.length == ERASURE_MAX_PACKET_SIZE && memcmp(out.data, packet, ERASURE_MAX_PACKET_SIZE) == 0);
+}
+
+int main(void) {
+    test_recovery();
+    test_expire();
+    test_size_limit();
+    return TEST_RESULT();
+}
@@ -0,0 +1,54 @@
+#include "test.h"
+#include "dataser_sublayer.h"
+
+static FOPSender fop;
+
+static SDUFrame data_frame(void) {
+    SDUFrame frame = {0};
+    frame.type = FRAME_FRAGMENTED;
+    frame.data.fragmented.pdu_header.PDU_ID = PDU_DATA;
+    return frame;
+}
+
+// After COP_MAX_RETRIES timeouts fop_p_resume() keeps the window, resends it from N(N)R and
+// grants a fresh retry count
+static void test_resume_after_failure(void) {
+    fop_p_init(&fop);
+    SDUFrame frame = data_frame();
+    CHECK(fop_p_accept(&fop, &frame));
+    CHECK(fop_p_accept(&fop, &frame));
+
+    uint32_t now = 0;
+    SDUFrame out;
+    while (fop_p_next(&fop, &out, now)) {
+    }
+    for (int i = 0; i < COP_MAX_RETRIES; i++) {
+        now += COP_RETRANSMIT_TIMEOUT_MS;
+        CHECK(fop_p_poll(&fop, now));
+        while (fop_p_next(&fop, &out, now)) {
+        }
+    }
+    CHECK(fop_p_failed(&fop));
+
+    fop_p_resume(&fop, now);
+    CHECK(!fop_p_failed(&fop));
+    CHECK(fop.count == 2);
+    CHECK(fop_p_next(&fop, &out, now));
+    CHECK(out.data.fragmented.pdu_header.FSN == fop.nnr);
+
+    // A single further timeout is not a failure any more
+    while (fop_p_next(&fop, &out, now)) {
+    }
+    now += COP_RETRANSMIT_TIMEOUT_MS;
+    CHECK(fop_p_poll(&fop, now));
+    CHECK(fop.retries == 1);
+
+    PLCW plcw = {2, false, PRIMARYCANAL, 0};
+    CHECK(fop_p_process_plcw(&fop, &plcw, now) == 2);
+    CHECK(fop_p_idle(&fop));
+}
+
+int main(void) {
+    test_resume_after_failure();
+    return TEST_RESULT();
+}
@@ -0,0 +1,87 @@
+#include "test.h"
+#include "pae_metrics.h"
+
+#include <string.h>
+
+static uint8_t snapshot[PAE_METRICS_SNAPSHOT_MAX];
+
+// Counters on a few ports, including values that need the full five varint bytes
+static void fill_registry(void) {
+    pae_metrics_reset();
+    pae_metrics_tx_frame(0, 209);
+    pae_metrics_tx_frame(0, 100);
+    pae_metrics_rx_frame(3, 50);
+    pae_metrics.frame.tx[NUM_PORTS - 1].frames = UINT32_MAX;
+    pae_metrics.frame.tx[NUM_PORTS - 1].bytes = 0x12345678u;
+    pae_metrics_invalid_frame();
+    pae_metrics_queue_depth(7);
+    pae_metrics_queue_depth(2);
+    pae_metrics_tx_latency(5);
+    pae_metrics_tx_latency(400);
+    pae_metrics_tx_latency(UINT32_MAX);
+    pae_metrics_reassembly_completed();
+    pae_metrics_reassembly_timeouts(3);
+}
+
+// What goes into a snapshot comes back out of pae_metrics_parse() unchanged
+static void test_round_trip(void) {
+    fill_registry();
+    size_t length = pae_metrics_snapshot(snapshot, sizeof(snapshot));
+    CHECK(length > 2 && length <= PAE_METRICS_SNAPSHOT_MAX);
+    CHECK(snapshot[1] == (uint8_t)(1u | 1u << 3 | 1u << (NUM_PORTS - 1)));
+
+    PaeMetrics parsed;
+    CHECK(pae_metrics_parse(snapshot, length, &parsed));
+    CHECK(memcmp(&parsed, &pae_metrics, sizeof(PaeMetrics)) == 0);
+    CHECK(parsed.frame.queue_high_water == 7 && parsed.frame.queue_depth == 2);
+    CHECK(parsed.frame.tx_latency_ms.buckets[PAE_METRICS_LATENCY_BUCKETS - 1] == 1);
+
+    // The worst case fits PAE_METRICS_SNAPSHOT_MAX
+    memset(&pae_metrics, 0xFF, sizeof(PaeMetrics));
+    CHECK(pae_metrics_snapshot(snapshot, sizeof(snapshot)) > 0);
+}
+
+// Every truncated snapshot is refused, on both sides, and `out` is left alone
+static void test_truncation(void) {
+    fill_registry();
+    size_t length = pae_metrics_snapshot(snapshot, sizeof(snapshot));
+    for (size_t cut = 0; cut < length; cut++) {
+        PaeMetrics parsed = {0};
+        parsed.io.reassembly_timeouts = 42;
+        CHECK(!pae_metrics_parse(snapshot, cut, &parsed));
+        CHECK(parsed.io.reassembly_timeouts == 42);
+
+        uint8_t small[PAE_METRICS_SNAPSHOT_MAX];
+        CHECK(pae_metrics_snapshot(small, cut) == 0);
+    }
+}
+
+// A corrupt header is refused: unknown version, or a bucket count larger than the data left
+static void test_corrupt(void) {
+    pae_metrics_reset();
+    size_t length = pae_metrics_snapshot(snapshot, sizeof(snapshot));
+    PaeMetrics parsed;
+    CHECK(pae_metrics_parse(snapshot, length, &parsed));
+
+    snapshot[0] = PAE_METRICS_VERSION + 1;
+    CHECK(!pae_metrics_parse(snapshot, length, &parsed));
+    snapshot[0] = PAE_METRICS_VERSION;
+
+    // Empty registry: [version][mask][5 zero counters][bucket count]...
+    const size_t bucket_count = 2 + 5;
+    CHECK(snapshot[bucket_count] == PAE_METRICS_LATENCY_BUCKETS);
+    uint8_t huge[PAE_METRICS_SNAPSHOT_MAX];
+    memcpy(huge, snapshot, bucket_count);
+    memcpy(&huge[bucket_count], (const uint8_t[]){0xFF, 0xFF, 0xFF, 0xFF, 0x0F}, 5);
+    memset(&huge[bucket_count + 5], 0, length - bucket_count - 1);
+    CHECK(!pae_metrics_parse(huge, length + 4, &parsed));
+}
+
+int main(void) {
+#if PAE_METRICS_ENABLED // The hot-path helpers compile to nothing otherwise
+    test_round_trip();
+#endif
+    test_truncation();
+    test_corrupt();
+    return TEST_RESULT();
+}
@@ -0,0 +1,89 @@
+#include "test.h"
+#include "rx_ring.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#define THREAD_PACKETS 1000000u
+
+static RxRing ring;
+
+// Full and empty ring, drop counting and the high water mark, from one thread
+static void test_single_thread(void) {
+    rx_ring_init(&ring);
+    CHECK(rx_ring_peek(&ring) == NULL);
+
+    for (uint32_t i = 0; i < RX_RING_DEPTH; i++) {
+        RxRingEntry *entry = rx_ring_reserve(&ring);
+        CHECK(entry != NULL);
+        if (entry != NULL) {
+            entry->received_ticks = i;
+            rx_ring_commit(&ring);
+        }
+    }
+    CHECK(rx_ring_count(&ring) == RX_RING_DEPTH);
+    CHECK(rx_ring_reserve(&ring) == NULL);
+    CHECK(ring.dropped == 1);
+    CHECK(ring.high_water == RX_RING_DEPTH);
+
+    for (uint32_t i = 0; i < RX_RING_DEPTH; i++) {
+        RxRingEntry *entry = rx_ring_peek(&ring);
+        CHECK(entry != NULL && entry->received_ticks == i);
+        rx_ring_release(&ring);
+    }
+    CHECK(rx_ring_peek(&ring) == NULL);
+    CHECK(ring.received == RX_RING_DEPTH);
+}
+
+// Producer thread standing in for the radio callback
+static void *produce(void *arg) {
+    (void)arg;
+    for (uint32_t i = 0; i < THREAD_PACKETS;) {
+        RxRingEntry *entry = rx_ring_reserve(&ring);
+        if (entry == NULL) {
+            sched_yield();
+            continue;
+        }
+        entry->length = (uint8_t)i;
+        entry->received_ticks = i;
+        entry->data[0] = (uint8_t)(i * 7);
+        entry->data[MAX_TOTAL_FRAME_SIZE - 1] = (uint8_t)(i * 13);
+        rx_ring_commit(&ring);
+        i++;
+    }
+    return NULL;
+}
+
+// Producer and consumer on two threads: every entry arrives once, in order and complete
+static void test_two_threads(void) {
+    rx_ring_init(&ring);
+    pthread_t producer;
+    CHECK(pthread_create(&producer, NULL, produce, NULL) == 0);
+
+    uint32_t bad = 0;
+    for (uint32_t expected = 0; expected < THREAD_PACKETS;) {
+        RxRingEntry *entry = rx_ring_peek(&ring);
+        if (entry == NULL) {
+            sched_yield();
+            continue;
+        }
+        if (entry->received_ticks != expected || entry->length != (uint8_t)expected ||
+            entry->data[0] != (uint8_t)(expected * 7) ||
+            entry->data[MAX_TOTAL_FRAME_SIZE - 1] != (uint8_t)(expected * 13)) {
+            bad++;
+        }
+        rx_ring_release(&ring);
+        expected++;
+    }
+    pthread_join(producer, NULL);
+
+    CHECK(bad == 0);
+    CHECK(ring.received == THREAD_PACKETS);
+    CHECK(rx_ring_count(&ring) == 0);
+}
+
+int main(void) {
+    test_single_thread();
+    test_two_threads();
+    return TEST_RESULT();
+}
@@ -0,0 +1,48 @@
+#include "test.h"
+#include "io_sublayer.h"
+#include "sdu_pool.h"
+
+#include <string.h>
+
+static IOBuffer buffer;
+
+// The copying segment_sdu() takes one pool block per segment: a packet of more segments
+// than the old 16-block pool must still be stored whole, and its blocks given back
+static void test_copying_segmentation(void) {
+    static uint8_t packet[4000];
+    for (size_t i = 0; i < sizeof(packet); i++) {
+        packet[i] = (uint8_t)(i * 31);
+    }
+    create_buffer(&buffer);
+    uint32_t in_use = sdu_pool_get_stats().in_use;
+
+    segment_sdu(packet, sizeof(packet), 1, 0, 0x100, 0, &buffer);
+    uint32_t packet_id = get_first_packet_id(&buffer);
+    CHECK(packet_id != NO_PACKET);
+    size_t count = 0;
+    const SDUFrame *frames = get_packet_frames(&buffer, packet_id, &count);
+    size_t expected = (sizeof(packet) + MAX_FRAGMENTED_SDU_SIZE - 1) / MAX_FRAGMENTED_SDU_SIZE;
+    CHECK(frames != NULL && count == expected);
+    CHECK(count > 16);
+    CHECK(sdu_pool_get_stats().in_use == in_use + count);
+
+    // Each segment holds its own copy of its slice of the packet
+    size_t offset = 0;
+    for (size_t i = 0; frames != NULL && i < count; i++) {
+        const PDUHeader *hdr = &frames[i].data.fragmented.pdu_header;
+        size_t length = ((size_t)hdr->data_length_high << 8) | hdr->data_length_low;
+        CHECK(sdu_pool_owns(frames[i].data.fragmented.sdu));
+        CHECK(offset + length <= sizeof(packet) &&
+              memcmp(frames[i].data.fragmented.sdu, packet + offset, length) == 0);
+        offset += length;
+    }
+    CHECK(offset == sizeof(packet));
+
+    free_buffer(&buffer, packet_id);
+    CHECK(sdu_pool_get_stats().in_use == in_use);
+}
+
+int main(void) {
+    test_copying_segmentation();
+    return TEST_RESULT();
+}
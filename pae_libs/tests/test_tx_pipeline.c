@@ -0,0 +1,117 @@
+#include "test.h"
+#include "tx_pipeline.h"
+#include "io_sublayer.h"
+#include "frame_sublayer.h"
+#include "fec.h"
+
+#include <string.h>
+
+// Stand-in radio: records when each frame starts; the test decides when TX_DONE comes
+#define MAX_STARTS 32
+
+typedef struct {
+    uint32_t now_ms;
+    size_t starts;
+    uint32_t start_ms[MAX_STARTS];
+    size_t length[MAX_STARTS];
+} FakeRadio;
+
+static bool fake_start_tx(void *radio, const uint8_t *data, size_t length, uint32_t timeout_ms) {
+    FakeRadio *fake = radio;
+    if (fake->starts < MAX_STARTS) {
+        fake->start_ms[fake->starts] = fake->now_ms;
+        fake->length[fake->starts] = length;
+    }
+    fake->starts++;
+    return true;
+}
+
+static const TxRadioOps fake_ops = {fake_start_tx};
+
+// SF7, 125 kHz, 4/5, 8 symbol preamble, explicit header, CRC on
+static const LoRaParams link = {7, 125000, 1, 8, false, true, false};
+
+static const SDUFrame* test_frame(void) {
+    static uint8_t payload[200];
+    static IOBuffer buffer;
+    memset(payload, 'x', sizeof(payload));
+    create_buffer(&buffer);
+    uint32_t id = create_unfragmented_sdu_pinned(payload, sizeof(payload), 0, 0, 0x100, 0, &buffer);
+    size_t count = 0;
+    return get_packet_frames(&buffer, id, &count);
+}
+
+// Frames back to back: each one starts a pacing interval after the previous one
+static void test_pacing(const SDUFrame *frame) {
+    static TxPipeline pipe;
+    FakeRadio radio = {0};
+    tx_pipeline_init(&pipe, &fake_ops, &radio, &link, LORA_RX_TURNAROUND_MS);
+
+    size_t submitted = 0;
+    for (radio.now_ms = 0; pipe.completed < 10 && radio.now_ms < 60000; radio.now_ms++) {
+        if (submitted < 10 && !tx_pipeline_full(&pipe)) {
+            CHECK(tx_pipeline_submit(&pipe, frame, radio.now_ms, radio.now_ms));
+            submitted++;
+        }
+        // The radio raises TX_DONE once the frame has been on air
+        if (pipe.on_air) {
+            uint32_t airtime_ms = (lora_time_on_air_us(&link, (uint8_t)radio.length[radio.starts - 1]) + 999) / 1000;
+            if (radio.now_ms - pipe.started_ms >= airtime_ms) {
+                tx_pipeline_on_tx_done(&pipe, true);
+            }
+        }
+        tx_pipeline_poll(&pipe, radio.now_ms);
+    }
+
+    CHECK(radio.starts == 10);
+    CHECK(pipe.completed == 10);
+    CHECK(pipe.failed == 0);
+    CHECK(tx_pipeline_idle(&pipe));
+
+    // The frame goes on air serialized and FEC-encoded (no parity bytes with -DFEC_PARITY=0)
+    uint8_t coded[MAX_TOTAL_FRAME_SIZE];
+    size_t coded_length = fec_encode(coded, serialize_into(frame, coded, sizeof(coded)), sizeof(coded));
+    CHECK(coded_length > 0 && radio.length[0] == coded_length);
+    uint32_t interval_ms = lora_frame_interval_ms(&link, (uint8_t)coded_length, LORA_RX_TURNAROUND_MS);
+    CHECK(interval_ms == (lora_time_on_air_us(&link, (uint8_t)coded_length) + 999) / 1000 + LORA_RX_TURNAROUND_MS);
+    for (size_t i = 1; i < radio.starts && i < MAX_STARTS; i++) {
+        CHECK(radio.start_ms[i] - radio.start_ms[i - 1] == interval_ms);
+    }
+}
+
+// TX_DONE never comes: the frame fails once its timeout has passed, and the slot is freed
+static void test_missing_tx_done(const SDUFrame *frame) {
+    static TxPipeline pipe;
+    FakeRadio radio = {0};
+    tx_pipeline_init(&pipe, &fake_ops, &radio, &link, LORA_RX_TURNAROUND_MS);
+
+    CHECK(tx_pipeline_submit(&pipe, frame, 0, 0));
+    CHECK(radio.starts == 1);
+    uint32_t timeout_ms = pipe.timeout_ms;
+
+    tx_pipeline_poll(&pipe, timeout_ms);
+    CHECK(pipe.on_air);
+    CHECK(pipe.failed == 0);
+
+    tx_pipeline_poll(&pipe, timeout_ms + 1);
+    CHECK(!pipe.on_air);
+    CHECK(pipe.failed == 1);
+    CHECK(pipe.completed == 0);
+    CHECK(tx_pipeline_idle(&pipe));
+
+    // A late TX_DONE of the failed frame is ignored
+    tx_pipeline_on_tx_done(&pipe, true);
+    CHECK(pipe.completed == 0);
+}
+
+int main(void) {
+    fec_init();
+    const SDUFrame *frame = test_frame();
+    CHECK(frame != NULL);
+    if (frame == NULL) {
+        return TEST_RESULT();
+    }
+    test_pacing(frame);
+    test_missing_tx_done(frame);
+    return TEST_RESULT();
+}
@@ -0,0 +1,108 @@
+#include "tx_pipeline.h"
+#include "frame_sublayer.h"
+#include "fec.h"
+#include "pae_metrics.h"
+
+#include <string.h>
+#include <stdio.h>
+
+#define TX_PIPELINE_MASK (TX_PIPELINE_DEPTH - 1)
+#define TX_PIPELINE_TIMEOUT_MARGIN_MS 50 // Slack on top of twice the time on air
+
+void tx_pipeline_init(TxPipeline *pipe, const TxRadioOps *ops, void *radio, const LoRaParams *link,
+    uint32_t turnaround_ms) {
+    memset(pipe, 0, sizeof(TxPipeline));
+    pipe->ops = ops;
+    pipe->radio = radio;
+    pipe->link = link;
+    pipe->turnaround_ms = turnaround_ms;
+}
+
+bool tx_pipeline_full(const TxPipeline *pipe) {
+    return pipe->slots[pipe->head].state != TX_SLOT_FREE;
+}
+
+bool tx_pipeline_idle(const TxPipeline *pipe) {
+    for (size_t i = 0; i < TX_PIPELINE_DEPTH; i++) {
+        if (pipe->slots[i].state != TX_SLOT_FREE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool tx_pipeline_submit(TxPipeline *pipe, const SDUFrame *frame, uint32_t enqueued_ms, uint32_t now_ms) {
+    if (frame == NULL || tx_pipeline_full(pipe)) {
+        return false;
+    }
+
+    TxSlot *slot = &pipe->slots[pipe->head];
+    size_t length = serialize_into(frame, slot->data, sizeof(slot->data));
+    slot->frame_length = (uint8_t)length;
+    if (length > 0) {
+        length = fec_encode(slot->data, length, sizeof(slot->data));
+    }
+    if (length == 0) {
+        fprintf(stderr, "Error: Frame does not fit in a TX slot.\n");
+        return false;
+    }
+    slot->length = (uint8_t)length;
+    slot->port_id = (frame->type == FRAME_FRAGMENTED) ? frame->data.fragmented.pdu_header.PortID
+                                                      : frame->data.unfragmented.header.PortID;
+    slot->enqueued_ms = enqueued_ms;
+    slot->state = TX_SLOT_STAGED;
+    pipe->head = (pipe->head + 1) & TX_PIPELINE_MASK;
+    pipe->submitted++;
+
+    tx_pipeline_poll(pipe, now_ms);
+    return true;
+}
+
+void tx_pipeline_poll(TxPipeline *pipe, uint32_t now_ms) {
+    if (pipe->latency_pending) {
+        // The interrupt has no clock; the main loop polls often enough for this resolution
+        pae_metrics_tx_latency(now_ms - pipe->done_enqueued_ms);
+        pipe->latency_pending = false;
+    }
+    if (pipe->on_air) {
+        if (now_ms - pipe->started_ms <= pipe->timeout_ms) {
+            return;
+        }
+        tx_pipeline_on_tx_done(pipe, false); // TX_DONE never came
+    }
+
+    TxSlot *slot = &pipe->slots[pipe->tail];
+    if (slot->state != TX_SLOT_STAGED || (int32_t)(now_ms - pipe->next_start_ms) < 0) {
+        return;
+    }
+
+    uint32_t airtime_ms = (lora_time_on_air_us(pipe->link, slot->length) + 999) / 1000;
+    pipe->air_slot = pipe->tail;
+    pipe->tail = (pipe->tail + 1) & TX_PIPELINE_MASK;
+    pipe->started_ms = now_ms;
+    pipe->timeout_ms = 2 * airtime_ms + TX_PIPELINE_TIMEOUT_MARGIN_MS;
+    pipe->next_start_ms = now_ms + lora_frame_interval_ms(pipe->link, slot->length, pipe->turnaround_ms);
+    slot->state = TX_SLOT_ON_AIR;
+    pipe->on_air = true;
+
+    if (!pipe->ops->start_tx(pipe->radio, slot->data, slot->length, 2 * airtime_ms)) {
+        tx_pipeline_on_tx_done(pipe, false);
+    }
+}
+
+void tx_pipeline_on_tx_done(TxPipeline *pipe, bool success) {
+    if (!pipe->on_air) {
+        return; // Late or spurious interrupt
+    }
+    TxSlot *slot = &pipe->slots[pipe->air_slot];
+    if (success) {
+        pipe->completed++;
+        pae_metrics_tx_frame(slot->port_id, slot->frame_length);
+        pipe->done_enqueued_ms = slot->enqueued_ms;
+        pipe->latency_pending = true;
+    } else {
+        pipe->failed++;
+    }
+    slot->state = TX_SLOT_FREE;
+    pipe->on_air = false;
+}
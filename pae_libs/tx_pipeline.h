@@ -0,0 +1,87 @@
+#ifndef TX_PIPELINE_H
+#define TX_PIPELINE_H
+
+#include "protocol_definitions.h"
+#include "lora_airtime.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Interrupt-driven TX engine. Frames are serialized and FEC-encoded into a ring of slots
+// while the previous frame is on air; the TX_DONE interrupt frees the slot and the next
+// staged frame is started as soon as the pacing interval (lora_frame_interval_ms()) allows.
+// Nothing blocks: tx_pipeline_submit() returns at once and tx_pipeline_poll() starts frames.
+#ifndef TX_PIPELINE_DEPTH
+#define TX_PIPELINE_DEPTH 2 // Frame on air + frame staged behind it, must be a power of two
+#endif
+
+#if (TX_PIPELINE_DEPTH & (TX_PIPELINE_DEPTH - 1)) != 0 || TX_PIPELINE_DEPTH > 128
+#error "TX_PIPELINE_DEPTH must be a power of two no larger than 128"
+#endif
+
+// Radio access used by the pipeline. On the board it drives the LR11xx; on Linux a stand-in
+// can record the frames and call tx_pipeline_on_tx_done() itself.
+typedef struct {
+    // Load `length` bytes into the radio and start transmitting, with a radio-side timeout.
+    // Returns false if the radio refused the frame.
+    bool (*start_tx)(void *radio, const uint8_t *data, size_t length, uint32_t timeout_ms);
+} TxRadioOps;
+
+typedef enum {
+    TX_SLOT_FREE = 0,
+    TX_SLOT_STAGED,   // Serialized, waiting for the radio
+    TX_SLOT_ON_AIR
+} TxSlotState;
+
+typedef struct {
+    uint8_t data[MAX_TOTAL_FRAME_SIZE]; // Serialized frame and FEC parity
+    uint8_t length;
+    uint8_t frame_length;   // Serialized frame without the parity, for the metrics
+    uint8_t port_id;
+    volatile uint8_t state; // TxSlotState, written from the TX_DONE handler
+    uint32_t enqueued_ms;   // Time the frame entered the stack
+} TxSlot;
+
+typedef struct {
+    TxSlot slots[TX_PIPELINE_DEPTH];
+    uint8_t head;              // Next slot to fill
+    uint8_t tail;              // Next slot to put on air
+    uint8_t air_slot;          // Slot on air while `on_air` is set
+    volatile bool on_air;
+    uint32_t started_ms;       // Start of the frame on air
+    uint32_t timeout_ms;       // Give up on the frame on air after this long
+    uint32_t next_start_ms;    // Earliest start of the next frame (pacing)
+    const TxRadioOps *ops;
+    void *radio;
+    const LoRaParams *link;
+    uint32_t turnaround_ms;    // Receiver turnaround added after each frame
+    uint32_t submitted;        // Frames accepted by tx_pipeline_submit()
+    volatile uint32_t completed; // Frames that reached TX_DONE
+    volatile uint32_t failed;  // Frames refused by the radio or timed out
+    volatile bool latency_pending; // A frame reached TX_DONE, its latency is recorded by the next poll
+    uint32_t done_enqueued_ms;     // Enqueue time of that frame
+} TxPipeline;
+
+void tx_pipeline_init(TxPipeline *pipe, const TxRadioOps *ops, void *radio, const LoRaParams *link,
+    uint32_t turnaround_ms);
+
+// Serialize and FEC-encode the frame into the next free slot, then start it if the radio
+// is ready. Returns false if every slot is busy (see tx_pipeline_full()) or the frame
+// cannot be serialized. The frame's SDU may be reused as soon as this returns.
+// `enqueued_ms` is when the frame entered the stack (SchedEntry.enqueued_ms, or `now_ms`):
+// the time from there to TX_DONE goes to the pae_metrics latency histogram.
+bool tx_pipeline_submit(TxPipeline *pipe, const SDUFrame *frame, uint32_t enqueued_ms, uint32_t now_ms);
+
+// Start the next staged frame once the radio is free and the pacing interval has passed,
+// and fail a frame whose TX_DONE never came. Call from the main loop.
+void tx_pipeline_poll(TxPipeline *pipe, uint32_t now_ms);
+
+// TX_DONE (success) or TX timeout (failure) of the frame on air. Safe to call from the
+// radio interrupt handler.
+void tx_pipeline_on_tx_done(TxPipeline *pipe, bool success);
+
+bool tx_pipeline_full(const TxPipeline *pipe);
+// True when no frame is staged or on air
+bool tx_pipeline_idle(const TxPipeline *pipe);
+
+#endif // TX_PIPELINE_H
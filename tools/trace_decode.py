@@ -0,0 +1,213 @@
+#!/usr/bin/env python3
+"""Decode tokenized traces (HAL_DBG_TRACE_TOKENIZED) back into text.
+
+The firmware sends each trace as a frame
+
+    [0xA5][level | flags][token low][token high][length][length bytes of arguments]
+
+where the token is the offset of the format string in the "hal_trace_fmt" section of the
+ELF file. Bytes outside frames are printed as they are, so plain text output still works.
+
+Usage:
+    trace_decode.py firmware.elf [capture.bin]    (reads stdin when no capture is given)
+    e.g. stty -F /dev/ttyACM0 921600 raw && trace_decode.py app.elf < /dev/ttyACM0
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+SECTION = "hal_trace_fmt"
+SYNC = 0xA5
+HEADER_SIZE = 5
+
+LEVEL_MASK = 0x3F
+FLAG_PLAIN = 0x40
+FLAG_ARRAY = 0x80
+
+LEVELS = {
+    1: ("ERROR: ", "\x1b[0;31m"),
+    2: ("WARN: ", "\x1b[0;33m"),
+    3: ("INFO: ", "\x1b[0;32m"),
+}
+COLOR_DEFAULT = "\x1b[0m"
+
+# Same walk as trace_token_pack() in common/src/smtc_hal_dbg_trace.c
+CONVERSION = re.compile(r"%(?P<flags>[-+ #0]*)(?P<width>\*|\d+)?(?:\.(?P<precision>\*|\d+))?"
+                        r"(?P<length>hh|h|ll|l|L|q|j|z|t)?(?P<type>[diuxXocpfFeEgGaAs%])")
+
+
+def read_section(path, name):
+    """Return the contents of section @name in the little endian ELF file at @path."""
+    with open(path, "rb") as f:
+        elf = f.read()
+    if elf[:4] != b"\x7fELF":
+        raise ValueError(f"{path} is not an ELF file")
+    is_64 = elf[4] == 2
+    if elf[5] != 1:
+        raise ValueError(f"{path} is not little endian")
+
+    if is_64:
+        shoff, = struct.unpack_from("<Q", elf, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", elf, 0x3A)
+        header = "<IIQQQQIIQQ"
+    else:
+        shoff, = struct.unpack_from("<I", elf, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", elf, 0x2E)
+        header = "<IIIIIIIIII"
+
+    sections = [struct.unpack_from(header, elf, shoff + i * shentsize) for i in range(shnum)]
+    names_offset = sections[shstrndx][4]
+    for section in sections:
+        start = names_offset + section[0]
+        section_name = elf[start:elf.index(b"\0", start)].decode()
+        if section_name == name:
+            offset, size = section[4], section[5]
+            return elf[offset:offset + size]
+    raise ValueError(f"{path} has no {name} section (built without HAL_DBG_TRACE_TOKENIZED?)")
+
+
+def format_string(strings, token):
+    end = strings.find(b"\0", token)
+    if token >= len(strings) or end < 0:
+        return None
+    return strings[token:end].decode(errors="replace")
+
+
+def render(fmt, args):
+    """Apply the C format @fmt to the packed little endian @args."""
+    out = []
+    position = 0
+    cursor = 0
+
+    def take(size, code):
+        nonlocal cursor
+        if cursor + size > len(args):
+            raise IndexError
+        value, = struct.unpack_from(code, args, cursor)
+        cursor += size
+        return value
+
+    for match in CONVERSION.finditer(fmt):
+        out.append(fmt[position:match.start()])
+        position = match.end()
+        kind = match.group("type")
+        if kind == "%":
+            out.append("%")
+            continue
+        try:
+            width = match.group("width") or ""
+            if width == "*":
+                width = str(take(4, "<i"))
+            precision = match.group("precision")
+            if precision == "*":
+                precision = str(take(4, "<i"))
+            spec = "%" + match.group("flags") + width + ("." + precision if precision is not None else "")
+
+            wide = match.group("length") in ("ll", "j")
+            if kind in "di":
+                value = take(8, "<q") if wide else take(4, "<i")
+                if match.group("length") == "hh":
+                    value = struct.unpack("<b", struct.pack("<B", value & 0xFF))[0]
+                elif match.group("length") == "h":
+                    value = struct.unpack("<h", struct.pack("<H", value & 0xFFFF))[0]
+                out.append((spec + "d") % value)
+            elif kind in "uxXoc":
+                value = take(8, "<Q") if wide else take(4, "<I")
+                if match.group("length") == "hh":
+                    value &= 0xFF
+                elif match.group("length") == "h":
+                    value &= 0xFFFF
+                out.append((spec + kind) % value)
+            elif kind == "p":
+                out.append("0x%08x" % take(4, "<I"))
+            elif kind in "fFeEgGaA":
+                value = take(8, "<d")
+                out.append(value.hex() if kind in "aA" else (spec + kind) % value)
+            elif kind == "s":
+                end = args.find(b"\0", cursor)
+                if end < 0:
+                    raise IndexError
+                out.append((spec + "s") % args[cursor:end].decode(errors="replace"))
+                cursor = end + 1
+        except IndexError:
+            out.append("<truncated>")
+            position = len(fmt)
+            break
+    out.append(fmt[position:])
+    return "".join(out)
+
+
+def render_array(msg, data):
+    lines = [f"{msg} - ({len(data)} bytes):\n"]
+    for start in range(0, len(data), 16):
+        lines.append(" ".join(f"{byte:02X}" for byte in data[start:start + 16]) + "\n")
+    return "".join(lines)
+
+
+def decode(strings, stream, out, color):
+    buffer = b""
+    while True:
+        chunk = stream.read1(256) if hasattr(stream, "read1") else stream.read(256)
+        if not chunk:
+            break
+        buffer += chunk
+        while buffer:
+            sync = buffer.find(bytes([SYNC]))
+            if sync < 0:
+                out.write(buffer.decode(errors="replace"))
+                buffer = b""
+                break
+            if sync > 0:
+                out.write(buffer[:sync].decode(errors="replace"))
+                buffer = buffer[sync:]
+            if len(buffer) < HEADER_SIZE or len(buffer) < HEADER_SIZE + buffer[4]:
+                break  # Wait for the rest of the frame
+
+            level = buffer[1]
+            token = buffer[2] | (buffer[3] << 8)
+            payload = buffer[HEADER_SIZE:HEADER_SIZE + buffer[4]]
+            fmt = format_string(strings, token)
+            if fmt is None:
+                # Not a frame (or a firmware/ELF mismatch): drop the sync byte and resynchronise
+                out.write(f"<unknown token 0x{token:04x}>\n")
+                buffer = buffer[1:]
+                continue
+            buffer = buffer[HEADER_SIZE + len(payload):]
+
+            if level & FLAG_ARRAY:
+                text = render_array(fmt, payload)
+            else:
+                text = render(fmt, payload)
+            if not level & FLAG_PLAIN and not level & FLAG_ARRAY:
+                prefix, level_color = LEVELS.get(level & LEVEL_MASK, ("", ""))
+                text = prefix + text
+                if color:
+                    text = level_color + text + COLOR_DEFAULT
+            out.write(text)
+        out.flush()
+    if buffer:
+        out.write(buffer.decode(errors="replace"))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode tokenized HAL traces")
+    parser.add_argument("elf", help="firmware ELF file the traces come from")
+    parser.add_argument("capture", nargs="?", help="captured UART output (default: stdin)")
+    parser.add_argument("--no-color", action="store_true", help="do not color the level prefixes")
+    options = parser.parse_args()
+
+    strings = read_section(options.elf, SECTION)
+    stream = open(options.capture, "rb") if options.capture else sys.stdin.buffer
+    try:
+        decode(strings, stream, sys.stdout, not options.no_color)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if options.capture:
+            stream.close()
+
+
+if __name__ == "__main__":
+    main()